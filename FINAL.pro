@@ -1,31 +1,74 @@
-QT       += core gui
+QT       += core gui sql concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++17
 
+# 使用SQLite在线备份API（需要Qt以 -system-sqlite 构建，与此处链接的libsqlite3为同一份）
+# 未启用时备份退化为 VACUUM INTO
+sqlite_direct {
+    DEFINES += CAMPUS_SQLITE_DIRECT
+    LIBS += -lsqlite3
+}
+
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
     activitymodel.cpp \
+    activitystore.cpp \
     adminwidget.cpp \
+    backupmanager.cpp \
+    benchmarks.cpp \
     csvexporttask.cpp \
+    csvwriter.cpp \
+    csvimporter.cpp \
     databasemanager.cpp \
+    kiosksnapshot.cpp \
     main.cpp \
     logindialog.cpp \
+    myenrollmentsmodel.cpp \
+    operationtrace.cpp \
     organizerwidget.cpp \
-    studentwidget.cpp
+    recurrence.cpp \
+    reportexporter.cpp \
+    selfcheck.cpp \
+    startuptrace.cpp \
+    stringpool.cpp \
+    studentwidget.cpp \
+    timelinelayout.cpp \
+    timelineview.cpp \
+    tracereplayer.cpp \
+    waitlistindex.cpp
 
 HEADERS += \
     activitymodel.h \
+    activitystore.h \
     adminwidget.h \
+    backupmanager.h \
+    benchmarks.h \
     csvexporttask.h \
+    csvwriter.h \
+    csvimporter.h \
     databasemanager.h \
+    kiosksnapshot.h \
     logindialog.h \
+    myenrollmentsmodel.h \
+    operationtrace.h \
     organizerwidget.h \
-    studentwidget.h
+    recurrence.h \
+    reportexporter.h \
+    rowmapping.h \
+    rowtypes.h \
+    selfcheck.h \
+    startuptrace.h \
+    stringpool.h \
+    studentwidget.h \
+    timelinelayout.h \
+    timelineview.h \
+    tracereplayer.h \
+    waitlistindex.h
 
 FORMS += \
     adminwidget.ui \
@@ -1,12 +1,110 @@
 //【阶段3：2024-05-22】创建活动模型类，连接数据库查询结果
 //【阶段4：2024-05-23】优化数据显示格式
+//【阶段16：2024-06-08】查询结果载入列式存储，排序过滤不再依赖QSortFilterProxyModel
+//【阶段26：2024-07-01】快照模式，数据直接来自映射文件
 
 #include "activitymodel.h"
 #include "databasemanager.h"
+#include "startuptrace.h"
+#include <QSqlQuery>
+#include <QTimer>
+#include <QSet>
+#include <QColor>
+#include <algorithm>
+
+namespace {
+
+// 首屏同步加载的行数，其余行在事件循环空闲时分批追加
+const int kFirstScreenRows = 100;
+const int kBatchRows = 2000;
+
+QString availabilityText(Availability availability)
+{
+    switch (availability) {
+    case Availability::Available: return "可报名";
+    case Availability::Conflict: return "时间冲突";
+    case Availability::Enrolled: return "已报名";
+    case Availability::Waitlisted: return "候补中";
+    case Availability::Full: return "已满员";
+    }
+    return QString();
+}
+
+}
 
 ActivityModel::ActivityModel(QObject *parent)
-    : QSqlQueryModel(parent)
+    : QAbstractTableModel(parent)
+    , m_sortColumn(-1)
+    , m_sortOrder(Qt::AscendingOrder)
+    , m_hasAvailability(false)
+    , m_loaded(false)
+    , m_userId(-1)
+    , m_hasMoreRows(false)
+    , m_lastLoadedId(-1)
+    , m_kiosk(false)
+{
+    DatabaseManager& db = DatabaseManager::instance();
+    connect(&db, &DatabaseManager::activitiesChanged, this, &ActivityModel::patchActivities);
+    connect(&db, &DatabaseManager::enrollmentsChanged, this, &ActivityModel::patchActivities);
+}
+
+int ActivityModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_kiosk ? m_snapshot.size() : m_rows.size();
+}
+
+int ActivityModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ActivityStore::ColumnCount;
+}
+
+QVariant ActivityModel::data(const QModelIndex& item, int role) const
 {
+    if (m_kiosk) {
+        return item.isValid() && role == Qt::DisplayRole && item.row() < m_snapshot.size()
+            ? snapshotData(snapshotRecord(item.row()), item.column()) : QVariant();
+    }
+
+    if (!item.isValid() || item.row() >= m_rows.size()) {
+        return QVariant();
+    }
+
+    const int row = m_rows.at(item.row());
+
+    if (role == Qt::DisplayRole) {
+        switch (item.column()) {
+        case ActivityStore::IdColumn: return m_store.id(row);
+        case ActivityStore::TitleColumn: return m_store.title(row);
+        case ActivityStore::OrganizerColumn: return m_store.organizer(row);
+        case ActivityStore::StartColumn:
+            return DatabaseManager::formatTime(QDateTime::fromSecsSinceEpoch(m_store.startTime(row)));
+        case ActivityStore::EndColumn:
+            return DatabaseManager::formatTime(QDateTime::fromSecsSinceEpoch(m_store.endTime(row)));
+        case ActivityStore::ParticipantsColumn:
+            return QString("%1/%2").arg(m_store.currentParticipants(row)).arg(m_store.maxParticipants(row));
+        case ActivityStore::StatusColumn: return m_store.status(row);
+        case ActivityStore::CategoryColumn: return m_store.category(row);
+        case ActivityStore::AvailabilityColumn:
+            return m_hasAvailability ? availabilityText(static_cast<Availability>(m_store.availability(row)))
+                                     : QVariant();
+        default: return QVariant();
+        }
+    }
+
+    // 冲突和满员的活动以颜色提示，无需点击报名按钮即可看到
+    if (role == Qt::ForegroundRole && m_hasAvailability) {
+        switch (static_cast<Availability>(m_store.availability(row))) {
+        case Availability::Conflict: return QColor(Qt::red);
+        case Availability::Full: return QColor(Qt::darkYellow);
+        case Availability::Enrolled: return QColor(Qt::darkGreen);
+        default: break;
+        }
+    }
+
+    return QVariant();
 }
 
 QVariant ActivityModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -21,16 +119,117 @@ QVariant ActivityModel::headerData(int section, Qt::Orientation orientation, int
         case 5: return "人数";
         case 6: return "状态";
         case 7: return "分类";
+        case 8: return "报名状态";
         default: return QVariant();
         }
     }
-    return QSqlQueryModel::headerData(section, orientation, role);
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+void ActivityModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column >= ActivityStore::ColumnCount) {
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+    m_sortColumn = column;
+    m_sortOrder = order;
+    rebuildRows();
+    emit layoutChanged();
 }
 
 void ActivityModel::refresh(const QString& role, int userId)
 {
-    QSqlQuery query = DatabaseManager::instance().getActivities(role, userId);
-    setQuery(std::move(query)); // 使用move避免已弃用的copy构造函数
+    if (m_kiosk) {
+        return;
+    }
+
+    // 放弃尚未加载完的上一次列表
+    m_hasMoreRows = false;
+    m_lastLoadedId = -1;
+
+    beginResetModel();
+    m_store.clear();
+    m_loaded = true;
+    m_role = role;
+    m_userId = userId;
+    m_hasAvailability = (role == "student" && userId > 0);
+
+    if (m_hasAvailability) {
+        // 一次查询得到带冲突/已报名/候补/满员标注的列表
+        const QVector<StudentActivityRow> rows = DatabaseManager::instance().getStudentActivityListing(userId);
+        m_store.reserve(rows.size());
+        for (const StudentActivityRow& row : rows) {
+            m_store.append(row.id, row.title, row.organizerName,
+                           DatabaseManager::parseTime(row.startTime).toSecsSinceEpoch(),
+                           DatabaseManager::parseTime(row.endTime).toSecsSinceEpoch(),
+                           row.maxParticipants, row.currentParticipants, row.status, row.category,
+                           static_cast<quint8>(row.availability));
+        }
+    } else {
+        m_hasMoreRows = appendPage(kFirstScreenRows);
+    }
+
+    rebuildRows();
+    endResetModel();
+    StartupTrace::mark("first table rows");
+
+    if (m_hasMoreRows) {
+        QTimer::singleShot(0, this, &ActivityModel::loadMore);
+    }
+}
+
+bool ActivityModel::appendPage(int maxRows)
+{
+    // 每页一条带LIMIT的查询，读完即释放，不在两批之间持有SQLite读事务阻塞写入方的检查点
+    QSqlQuery query = DatabaseManager::instance().getActivityPage(m_role, m_userId, m_lastLoadedId, maxRows);
+    int count = 0;
+    ActivityListRow row;
+    while (query.next()) {
+        readRow(query, row);
+        m_store.append(row.id, row.title, row.organizerName,
+                       DatabaseManager::parseTime(row.startTime).toSecsSinceEpoch(),
+                       DatabaseManager::parseTime(row.endTime).toSecsSinceEpoch(),
+                       row.maxParticipants, row.currentParticipants, row.status, row.category);
+        m_lastLoadedId = row.id;
+        ++count;
+    }
+    query.finish();
+    return count == maxRows;
+}
+
+void ActivityModel::loadMore()
+{
+    if (!m_hasMoreRows) {
+        return;
+    }
+
+    const bool filtered = !m_statusFilter.isEmpty() || !m_categoryFilter.isEmpty()
+                          || (m_windowFrom.isValid() && m_windowTo.isValid());
+    const int oldRows = m_rows.size();
+    const int oldStoreRows = m_store.size();
+    m_hasMoreRows = appendPage(kBatchRows);
+    const int added = m_store.size() - oldStoreRows;
+
+    if (added > 0) {
+        if (m_sortColumn >= 0 || filtered) {
+            // 新行可能插入到任意位置
+            beginResetModel();
+            rebuildRows();
+            endResetModel();
+        } else {
+            beginInsertRows(QModelIndex(), oldRows, oldRows + added - 1);
+            rebuildRows();
+            endInsertRows();
+        }
+    }
+
+    if (m_hasMoreRows) {
+        QTimer::singleShot(0, this, &ActivityModel::loadMore);
+    } else {
+        StartupTrace::mark("all table rows");
+    }
 }
 
 int ActivityModel::getActivityId(int row) const
@@ -39,6 +238,250 @@ int ActivityModel::getActivityId(int row) const
         return -1;
     }
     
-    QModelIndex index = this->index(row, 0);
-    return data(index).toInt();
+    return m_kiosk ? m_snapshot.id(snapshotRecord(row)) : m_store.id(m_rows.at(row));
+}
+
+bool ActivityModel::activityDetail(int row, ActivityDetail& detail) const
+{
+    const int activityId = m_kiosk ? -1 : getActivityId(row);
+    return activityId >= 0 && DatabaseManager::instance().getActivityDetail(activityId, detail);
+}
+
+bool ActivityModel::openSnapshot(const QString& fileName, QString& error)
+{
+    m_hasMoreRows = false;
+
+    beginResetModel();
+    m_store.clear();
+    m_rows.clear();
+    m_loaded = false;
+    m_hasAvailability = false;
+    const bool ok = m_snapshot.open(fileName, error);
+    m_kiosk = ok;
+    endResetModel();
+
+    if (ok) {
+        StartupTrace::mark("snapshot mapped");
+    }
+    return ok;
+}
+
+int ActivityModel::snapshotRecord(int row) const
+{
+    // 快照按开始时间升序存放，只有按开始时间倒序时需要换算
+    const bool reversed = m_sortColumn == ActivityStore::StartColumn && m_sortOrder == Qt::DescendingOrder;
+    return reversed ? m_snapshot.size() - 1 - row : row;
+}
+
+QVariant ActivityModel::snapshotData(int record, int column) const
+{
+    switch (column) {
+    case ActivityStore::IdColumn: return m_snapshot.id(record);
+    case ActivityStore::TitleColumn: return m_snapshot.title(record);
+    case ActivityStore::OrganizerColumn: return m_snapshot.organizer(record);
+    case ActivityStore::StartColumn:
+        return DatabaseManager::formatTime(QDateTime::fromSecsSinceEpoch(m_snapshot.startTime(record)));
+    case ActivityStore::EndColumn:
+        return DatabaseManager::formatTime(QDateTime::fromSecsSinceEpoch(m_snapshot.endTime(record)));
+    case ActivityStore::ParticipantsColumn:
+        return QString("%1/%2").arg(m_snapshot.currentParticipants(record)).arg(m_snapshot.maxParticipants(record));
+    case ActivityStore::StatusColumn: return QStringLiteral("approved");
+    case ActivityStore::CategoryColumn: return m_snapshot.category(record);
+    default: return QVariant();
+    }
+}
+
+void ActivityModel::applyStatusChange(const QList<int>& activityIds, const QString& status)
+{
+    if (activityIds.isEmpty()) {
+        return;
+    }
+
+    QSet<int> changed;
+    for (int id : activityIds) {
+        int row = m_store.rowOf(id);
+        if (row >= 0) {
+            m_store.setStatus(row, status);
+            changed.insert(row);
+        }
+    }
+
+    // 状态参与排序或过滤时需要重排，否则只通知受影响的单元格
+    if (m_sortColumn == ActivityStore::StatusColumn || !m_statusFilter.isEmpty()) {
+        emit layoutAboutToBeChanged();
+        rebuildRows();
+        emit layoutChanged();
+        return;
+    }
+
+    for (int viewRow = 0; viewRow < m_rows.size(); ++viewRow) {
+        if (changed.contains(m_rows.at(viewRow))) {
+            QModelIndex cell = index(viewRow, ActivityStore::StatusColumn);
+            emit dataChanged(cell, cell, { Qt::DisplayRole });
+        }
+    }
+}
+
+void ActivityModel::patchActivities(const QList<int>& activityIds)
+{
+    if (!m_loaded || activityIds.isEmpty()) {
+        return;
+    }
+
+    // 学生视图的冲突标注依赖整个日程，重新执行那一次查询即可
+    if (m_hasAvailability) {
+        refresh(m_role, m_userId);
+        return;
+    }
+
+    QSqlQuery query = DatabaseManager::instance().getActivities(m_role, m_userId, activityIds);
+
+    QSet<int> changedRows;
+    bool structural = false;    // 出现新增行时需要整体重置
+    for (const ActivityListRow& activity : fetchRows<ActivityListRow>(query, activityIds.size())) {
+        const int row = m_store.rowOf(activity.id);
+        if (row < 0) {
+            structural = true;
+            break;
+        }
+        m_store.update(row, activity.title, activity.organizerName,
+                       DatabaseManager::parseTime(activity.startTime).toSecsSinceEpoch(),
+                       DatabaseManager::parseTime(activity.endTime).toSecsSinceEpoch(),
+                       activity.maxParticipants, activity.currentParticipants,
+                       activity.status, activity.category);
+        changedRows.insert(row);
+    }
+
+    // 已有的行没有查回来，说明被删除/归档或不再符合角色条件
+    for (int id : activityIds) {
+        const int row = m_store.rowOf(id);
+        if (row >= 0 && !changedRows.contains(row)) {
+            structural = true;
+        }
+    }
+
+    if (structural) {
+        refresh(m_role, m_userId);
+        return;
+    }
+
+    const bool filtered = !m_statusFilter.isEmpty() || !m_categoryFilter.isEmpty()
+                          || (m_windowFrom.isValid() && m_windowTo.isValid());
+    if (m_sortColumn >= 0 || filtered) {
+        emit layoutAboutToBeChanged();
+        rebuildRows();
+        emit layoutChanged();
+        return;
+    }
+
+    for (int viewRow = 0; viewRow < m_rows.size(); ++viewRow) {
+        if (changedRows.contains(m_rows.at(viewRow))) {
+            emit dataChanged(index(viewRow, 0), index(viewRow, ActivityStore::ColumnCount - 1));
+        }
+    }
+}
+
+void ActivityModel::setStatusFilter(const QStringList& statuses)
+{
+    beginResetModel();
+    m_statusFilter = statuses;
+    rebuildRows();
+    endResetModel();
+}
+
+void ActivityModel::setCategoryFilter(const QStringList& categories)
+{
+    beginResetModel();
+    m_categoryFilter = categories;
+    rebuildRows();
+    endResetModel();
+}
+
+void ActivityModel::setTimeWindow(const QDateTime& from, const QDateTime& to)
+{
+    beginResetModel();
+    m_windowFrom = from;
+    m_windowTo = to;
+    rebuildRows();
+    endResetModel();
+}
+
+void ActivityModel::clearFilters()
+{
+    beginResetModel();
+    m_statusFilter.clear();
+    m_categoryFilter.clear();
+    m_windowFrom = QDateTime();
+    m_windowTo = QDateTime();
+    rebuildRows();
+    endResetModel();
+}
+
+QBitArray ActivityModel::filterMask() const
+{
+    QBitArray mask(m_store.size(), true);
+
+    if (!m_statusFilter.isEmpty()) {
+        QBitArray statusBits(m_store.size());
+        for (const QString& status : m_statusFilter) {
+            int code = m_store.statusCode(status);
+            if (code >= 0) {
+                statusBits |= m_store.statusMask(code);
+            }
+        }
+        mask &= statusBits;
+    }
+
+    if (!m_categoryFilter.isEmpty()) {
+        QBitArray categoryBits(m_store.size());
+        for (const QString& category : m_categoryFilter) {
+            int code = m_store.categoryCode(category);
+            if (code >= 0) {
+                categoryBits |= m_store.categoryMask(code);
+            }
+        }
+        mask &= categoryBits;
+    }
+
+    if (m_windowFrom.isValid() && m_windowTo.isValid()) {
+        mask &= m_store.timeWindowMask(m_windowFrom.toSecsSinceEpoch(), m_windowTo.toSecsSinceEpoch());
+    }
+
+    return mask;
+}
+
+void ActivityModel::rebuildRows()
+{
+    // 快照模式下行号直接对应快照记录，见snapshotRecord
+    if (m_kiosk) {
+        return;
+    }
+
+    const bool filtered = !m_statusFilter.isEmpty() || !m_categoryFilter.isEmpty()
+                          || (m_windowFrom.isValid() && m_windowTo.isValid());
+    const QBitArray mask = filtered ? filterMask() : QBitArray();
+
+    m_rows.clear();
+    m_rows.reserve(m_store.size());
+
+    auto accept = [&](int row) {
+        if (!filtered || mask.testBit(row)) {
+            m_rows.append(row);
+        }
+    };
+
+    if (m_sortColumn >= 0) {
+        const QVector<int>& permutation =
+            m_store.sortPermutation(static_cast<ActivityStore::Column>(m_sortColumn));
+        if (m_sortOrder == Qt::AscendingOrder) {
+            std::for_each(permutation.cbegin(), permutation.cend(), accept);
+        } else {
+            std::for_each(permutation.crbegin(), permutation.crend(), accept);
+        }
+    } else {
+        // 未排序时保持查询顺序（创建时间倒序）
+        for (int row = 0; row < m_store.size(); ++row) {
+            accept(row);
+        }
+    }
 }
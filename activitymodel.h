@@ -1,32 +1,101 @@
 #ifndef ACTIVITYMODEL_H
 #define ACTIVITYMODEL_H
 
-#include <QSqlQueryModel>
-#include <QSqlQuery>
+#include <QAbstractTableModel>
 #include <QVariant>
+#include <QVector>
+#include <QList>
+#include <QStringList>
+#include <QDateTime>
+#include <QSqlQuery>
+#include "activitystore.h"
+#include "databasemanager.h"
+#include "kiosksnapshot.h"
 
 //【阶段3：2024-05-22】实现活动数据模型类，用于TableView数据展示
 //【阶段4：2024-05-23】扩展模型功能，添加数据格式化方法
+//【阶段16：2024-06-08】改为基于列式存储的表格模型，原生排序和位图过滤
+//【阶段26：2024-07-01】自助查询机模式：直接读取映射的只读快照
 
 /**
  * @brief 活动数据模型类
- * 继承自QSqlQueryModel，用于在TableView中展示活动列表
+ * 数据保存在ActivityStore列式存储中，排序和过滤直接作用于原生数组，
+ * 只有视图实际请求的单元格才会转换为QVariant
  */
-class ActivityModel : public QSqlQueryModel
+class ActivityModel : public QAbstractTableModel
 {
     Q_OBJECT
 
 public:
     explicit ActivityModel(QObject *parent = nullptr);
     
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& item, int role = Qt::DisplayRole) const override;
+    
     // 重写headerData方法，自定义列标题
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
     
-    // 刷新数据
+    // 使用预计算的排序置换
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+    
+    // 刷新数据（学生角色会带上可报名状态标注）
+    // 管理员和发起人：首屏行同步加载后立即可见，其余行在事件循环中按页追加；
+    // 学生：冲突标注需要完整的日程，整个列表一次查询取回
     void refresh(const QString& role = "", int userId = -1);
     
     // 获取活动ID（根据行号）
     int getActivityId(int row) const;
+    
+    // 选中行的完整详情（含描述），经DatabaseManager的详情缓存查询（自助查询机模式下没有详情）
+    bool activityDetail(int row, ActivityDetail& detail) const;
+    
+    // 自助查询机模式：改为直接读取映射的快照文件，不访问数据库，不再响应数据库变更；
+    // 可重复调用以切换到新导出的快照。此模式下只支持按开始时间排序，过滤条件不生效
+    bool openSnapshot(const QString& fileName, QString& error);
+    bool isKiosk() const { return m_kiosk; }
+    
+    // 批量审批后就地更新对应行的状态，避免整表重新查询
+    void applyStatusChange(const QList<int>& activityIds, const QString& status);
+    
+    // 过滤条件（空列表/无效时间表示不过滤）
+    void setStatusFilter(const QStringList& statuses);
+    void setCategoryFilter(const QStringList& categories);
+    void setTimeWindow(const QDateTime& from, const QDateTime& to);
+    void clearFilters();
+
+private slots:
+    // 响应其他进程的变更，只重新查询受影响的活动
+    void patchActivities(const QList<int>& activityIds);
+    // 分批追加首屏之后的剩余行
+    void loadMore();
+
+private:
+    // 根据当前排序和过滤条件重建可见行
+    void rebuildRows();
+    QBitArray filterMask() const;
+    // 读取下一页（最多maxRows行），没有更多行时返回false
+    bool appendPage(int maxRows);
+    // 快照模式下视图行号对应的记录下标
+    int snapshotRecord(int row) const;
+    QVariant snapshotData(int record, int column) const;
+
+    ActivityStore m_store;
+    QVector<int> m_rows;            // 视图行号 -> 存储行号
+    int m_sortColumn;
+    Qt::SortOrder m_sortOrder;
+    QStringList m_statusFilter;
+    QStringList m_categoryFilter;
+    QDateTime m_windowFrom;
+    QDateTime m_windowTo;
+    bool m_hasAvailability;         // 当前数据是否带可报名标注
+    bool m_loaded;                  // 是否已调用过refresh
+    QString m_role;
+    int m_userId;
+    bool m_hasMoreRows;             // 首屏之后是否还有未读取的页
+    int m_lastLoadedId;             // 已读取的最后一行的活动ID，下一页从它之后开始
+    KioskSnapshot m_snapshot;
+    bool m_kiosk;                   // 是否为快照模式
 };
 
 #endif // ACTIVITYMODEL_H
@@ -0,0 +1,235 @@
+//【阶段16：2024-06-08】列式活动存储：整数编码字符串，缓存排序置换和过滤位图
+
+#include "activitystore.h"
+#include "stringpool.h"
+#include <algorithm>
+#include <numeric>
+
+void ActivityStore::clear()
+{
+    m_ids.clear();
+    m_titles.clear();
+    m_organizerCodes.clear();
+    m_startTimes.clear();
+    m_endTimes.clear();
+    m_maxParticipants.clear();
+    m_currentParticipants.clear();
+    m_statusCodes.clear();
+    m_categoryCodes.clear();
+    m_availability.clear();
+    m_statusNames.clear();
+    m_statusLookup.clear();
+    m_categoryNames.clear();
+    m_categoryLookup.clear();
+    m_organizerNames.clear();
+    m_organizerLookup.clear();
+    m_rowById.clear();
+    m_permutations.clear();
+    m_statusMasks.clear();
+    m_categoryMasks.clear();
+}
+
+void ActivityStore::reserve(int rows)
+{
+    m_ids.reserve(rows);
+    m_titles.reserve(rows);
+    m_organizerCodes.reserve(rows);
+    m_startTimes.reserve(rows);
+    m_endTimes.reserve(rows);
+    m_maxParticipants.reserve(rows);
+    m_currentParticipants.reserve(rows);
+    m_statusCodes.reserve(rows);
+    m_categoryCodes.reserve(rows);
+    m_availability.reserve(rows);
+    m_rowById.reserve(rows);
+}
+
+int ActivityStore::intern(const QString& value, QVector<QString>& names, QHash<QString, int>& lookup)
+{
+    auto it = lookup.constFind(value);
+    if (it != lookup.constEnd()) {
+        return it.value();
+    }
+    const int code = names.size();
+    names.append(StringPool::intern(value));
+    lookup.insert(value, code);
+    return code;
+}
+
+int ActivityStore::append(int id, const QString& title, const QString& organizer,
+                          qint64 startTime, qint64 endTime, int maxParticipants,
+                          int currentParticipants, const QString& status, const QString& category,
+                          quint8 availability)
+{
+    const int row = m_ids.size();
+    m_ids.append(id);
+    m_titles.append(title);
+    m_organizerCodes.append(quint32(intern(organizer, m_organizerNames, m_organizerLookup)));
+    m_startTimes.append(startTime);
+    m_endTimes.append(endTime);
+    m_maxParticipants.append(maxParticipants);
+    m_currentParticipants.append(currentParticipants);
+    m_statusCodes.append(quint8(intern(status, m_statusNames, m_statusLookup)));
+    m_categoryCodes.append(quint16(intern(category, m_categoryNames, m_categoryLookup)));
+    m_availability.append(availability);
+    m_rowById.insert(id, row);
+
+    // 新增行后所有缓存都需要重新计算
+    invalidateCaches();
+    return row;
+}
+
+void ActivityStore::update(int row, const QString& title, const QString& organizer,
+                           qint64 startTime, qint64 endTime, int maxParticipants,
+                           int currentParticipants, const QString& status, const QString& category)
+{
+    m_titles[row] = title;
+    m_organizerCodes[row] = quint32(intern(organizer, m_organizerNames, m_organizerLookup));
+    m_startTimes[row] = startTime;
+    m_endTimes[row] = endTime;
+    m_maxParticipants[row] = maxParticipants;
+    m_currentParticipants[row] = currentParticipants;
+    m_statusCodes[row] = quint8(intern(status, m_statusNames, m_statusLookup));
+    m_categoryCodes[row] = quint16(intern(category, m_categoryNames, m_categoryLookup));
+    invalidateCaches();
+}
+
+void ActivityStore::setStatus(int row, const QString& status)
+{
+    m_statusCodes[row] = quint8(intern(status, m_statusNames, m_statusLookup));
+    invalidateStatusCaches();
+}
+
+void ActivityStore::invalidateCaches()
+{
+    m_permutations.clear();
+    m_statusMasks.clear();
+    m_categoryMasks.clear();
+}
+
+void ActivityStore::invalidateStatusCaches()
+{
+    if (m_permutations.size() > StatusColumn) {
+        m_permutations[StatusColumn].clear();
+    }
+    m_statusMasks.clear();
+}
+
+QVector<int> ActivityStore::nameRanks(const QVector<QString>& names)
+{
+    QVector<int> order(names.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&names](int a, int b) {
+        return names.at(a) < names.at(b);
+    });
+
+    QVector<int> ranks(names.size());
+    for (int i = 0; i < order.size(); ++i) {
+        ranks[order.at(i)] = i;
+    }
+    return ranks;
+}
+
+const QVector<int>& ActivityStore::sortPermutation(Column column) const
+{
+    if (m_permutations.size() != ColumnCount) {
+        m_permutations.resize(ColumnCount);
+    }
+
+    QVector<int>& permutation = m_permutations[column];
+    if (permutation.size() == size()) {
+        return permutation;
+    }
+
+    permutation.resize(size());
+    std::iota(permutation.begin(), permutation.end(), 0);
+
+    // 直接比较原生数组元素，避免装箱
+    auto sortBy = [&permutation](const auto& values) {
+        std::stable_sort(permutation.begin(), permutation.end(), [&values](int a, int b) {
+            return values.at(a) < values.at(b);
+        });
+    };
+
+    switch (column) {
+    case IdColumn: sortBy(m_ids); break;
+    case TitleColumn: sortBy(m_titles); break;
+    case StartColumn: sortBy(m_startTimes); break;
+    case EndColumn: sortBy(m_endTimes); break;
+    case ParticipantsColumn: sortBy(m_currentParticipants); break;
+    case AvailabilityColumn: sortBy(m_availability); break;
+    case StatusColumn: {
+        const QVector<int> ranks = nameRanks(m_statusNames);
+        std::stable_sort(permutation.begin(), permutation.end(), [this, &ranks](int a, int b) {
+            return ranks.at(m_statusCodes.at(a)) < ranks.at(m_statusCodes.at(b));
+        });
+        break;
+    }
+    case OrganizerColumn: {
+        const QVector<int> ranks = nameRanks(m_organizerNames);
+        std::stable_sort(permutation.begin(), permutation.end(), [this, &ranks](int a, int b) {
+            return ranks.at(m_organizerCodes.at(a)) < ranks.at(m_organizerCodes.at(b));
+        });
+        break;
+    }
+    case CategoryColumn: {
+        const QVector<int> ranks = nameRanks(m_categoryNames);
+        std::stable_sort(permutation.begin(), permutation.end(), [this, &ranks](int a, int b) {
+            return ranks.at(m_categoryCodes.at(a)) < ranks.at(m_categoryCodes.at(b));
+        });
+        break;
+    }
+    default:
+        break;
+    }
+
+    return permutation;
+}
+
+const QBitArray& ActivityStore::statusMask(int code) const
+{
+    auto it = m_statusMasks.find(code);
+    if (it == m_statusMasks.end()) {
+        QBitArray mask(size());
+        for (int row = 0; row < size(); ++row) {
+            if (m_statusCodes.at(row) == code) {
+                mask.setBit(row);
+            }
+        }
+        it = m_statusMasks.insert(code, mask);
+    }
+    return it.value();
+}
+
+const QBitArray& ActivityStore::categoryMask(int code) const
+{
+    auto it = m_categoryMasks.find(code);
+    if (it == m_categoryMasks.end()) {
+        QBitArray mask(size());
+        for (int row = 0; row < size(); ++row) {
+            if (m_categoryCodes.at(row) == code) {
+                mask.setBit(row);
+            }
+        }
+        it = m_categoryMasks.insert(code, mask);
+    }
+    return it.value();
+}
+
+QBitArray ActivityStore::timeWindowMask(qint64 from, qint64 to) const
+{
+    QBitArray mask(size());
+
+    // 按开始时间排序后二分定位 start < to 的前缀，再逐个检查 end > from
+    const QVector<int>& byStart = sortPermutation(StartColumn);
+    auto last = std::lower_bound(byStart.begin(), byStart.end(), to, [this](int row, qint64 value) {
+        return m_startTimes.at(row) < value;
+    });
+
+    for (auto it = byStart.begin(); it != last; ++it) {
+        if (m_endTimes.at(*it) > from) {
+            mask.setBit(*it);
+        }
+    }
+    return mask;
+}
@@ -0,0 +1,111 @@
+#ifndef ACTIVITYSTORE_H
+#define ACTIVITYSTORE_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QBitArray>
+
+//【阶段16：2024-06-08】实现列式活动存储，支持预计算排序置换和位图过滤
+
+/**
+ * @brief 列式（struct-of-arrays）活动存储
+ * 每列一个连续数组，状态、分类和发起人字符串驻留为整数编码（名称表取自StringPool，多个存储共享）；
+ * 排序结果按列缓存为行号置换，过滤条件以位图表示，全程不经过QVariant。
+ */
+class ActivityStore
+{
+public:
+    enum Column {
+        IdColumn = 0,
+        TitleColumn,
+        OrganizerColumn,
+        StartColumn,
+        EndColumn,
+        ParticipantsColumn,
+        StatusColumn,
+        CategoryColumn,
+        AvailabilityColumn,     // 学生视角的可报名状态
+        ColumnCount
+    };
+
+    void clear();
+    void reserve(int rows);
+
+    // 追加一行，返回行号
+    int append(int id, const QString& title, const QString& organizer,
+               qint64 startTime, qint64 endTime, int maxParticipants,
+               int currentParticipants, const QString& status, const QString& category,
+               quint8 availability = 0);
+
+    int size() const { return m_ids.size(); }
+
+    // 按行号读取
+    int id(int row) const { return m_ids.at(row); }
+    const QString& title(int row) const { return m_titles.at(row); }
+    const QString& organizer(int row) const { return m_organizerNames.at(m_organizerCodes.at(row)); }
+    qint64 startTime(int row) const { return m_startTimes.at(row); }
+    qint64 endTime(int row) const { return m_endTimes.at(row); }
+    int maxParticipants(int row) const { return m_maxParticipants.at(row); }
+    int currentParticipants(int row) const { return m_currentParticipants.at(row); }
+    const QString& status(int row) const { return m_statusNames.at(m_statusCodes.at(row)); }
+    const QString& category(int row) const { return m_categoryNames.at(m_categoryCodes.at(row)); }
+    quint8 availability(int row) const { return m_availability.at(row); }
+
+    // 活动ID -> 行号，不存在返回-1
+    int rowOf(int activityId) const { return m_rowById.value(activityId, -1); }
+
+    // 就地替换一行的全部字段（活动ID不变）
+    void update(int row, const QString& title, const QString& organizer,
+                qint64 startTime, qint64 endTime, int maxParticipants,
+                int currentParticipants, const QString& status, const QString& category);
+
+    // 就地修改状态（会使状态列的排序和位图缓存失效）
+    void setStatus(int row, const QString& status);
+
+    // 字符串编码，未出现过的值返回-1
+    int statusCode(const QString& status) const { return m_statusLookup.value(status, -1); }
+    int categoryCode(const QString& category) const { return m_categoryLookup.value(category, -1); }
+    int organizerCode(const QString& organizer) const { return m_organizerLookup.value(organizer, -1); }
+
+    // 按列升序排序后的行号置换（首次调用时计算并缓存）
+    const QVector<int>& sortPermutation(Column column) const;
+
+    // 位图过滤：第i位表示第i行是否满足条件
+    const QBitArray& statusMask(int code) const;
+    const QBitArray& categoryMask(int code) const;
+    // 时间窗口 [from, to) 内有交集的活动
+    QBitArray timeWindowMask(qint64 from, qint64 to) const;
+
+private:
+    static int intern(const QString& value, QVector<QString>& names, QHash<QString, int>& lookup);
+    // 编码按名称排序后的名次，用于整数比较排序
+    static QVector<int> nameRanks(const QVector<QString>& names);
+    void invalidateStatusCaches();
+    void invalidateCaches();
+
+    QVector<int> m_ids;
+    QVector<QString> m_titles;
+    QVector<quint32> m_organizerCodes;
+    QVector<qint64> m_startTimes;          // 秒级时间戳
+    QVector<qint64> m_endTimes;
+    QVector<int> m_maxParticipants;
+    QVector<int> m_currentParticipants;
+    QVector<quint8> m_statusCodes;
+    QVector<quint16> m_categoryCodes;
+    QVector<quint8> m_availability;
+
+    QVector<QString> m_statusNames;
+    QHash<QString, int> m_statusLookup;
+    QVector<QString> m_categoryNames;
+    QHash<QString, int> m_categoryLookup;
+    QVector<QString> m_organizerNames;
+    QHash<QString, int> m_organizerLookup;
+    QHash<int, int> m_rowById;
+
+    mutable QVector<QVector<int>> m_permutations;   // 按列缓存，空表示未计算
+    mutable QHash<int, QBitArray> m_statusMasks;
+    mutable QHash<int, QBitArray> m_categoryMasks;
+};
+
+#endif // ACTIVITYSTORE_H
@@ -1,14 +1,173 @@
 #include "adminwidget.h"
 #include "ui_adminwidget.h"
+#include "csvimporter.h"
+#include "activitymodel.h"
+#include "databasemanager.h"
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QMessageBox>
 
-adminwidget::adminwidget(QWidget *parent)
+namespace {
+
+// 导入结果摘要，错误只列出前若干条，完整列表见调试输出
+QString importSummary(const CsvImportResult& result)
+{
+    const int kMaxErrors = 20;
+
+    QString text = QString("%1共%2行，成功%3行，失败%4行，耗时%5ms，%6行/秒")
+                       .arg(result.dryRun ? "[试运行] " : "")
+                       .arg(result.totalRows).arg(result.importedRows).arg(result.failedRows)
+                       .arg(result.elapsedMs).arg(qRound(result.rowsPerSecond));
+    for (int i = 0; i < result.errors.size() && i < kMaxErrors; ++i) {
+        text += QString("\n第%1行: %2").arg(result.errors.at(i).line).arg(result.errors.at(i).message);
+    }
+    if (result.errors.size() > kMaxErrors) {
+        text += QString("\n……另有%1条错误").arg(result.errors.size() - kMaxErrors);
+    }
+    return text;
+}
+
+// 批量审批结果摘要：成功数量及每个失败活动的原因
+QString reviewSummary(const QString& action, const QList<ReviewResult>& results)
+{
+    int succeeded = 0;
+    QString failures;
+    for (const ReviewResult& result : results) {
+        if (result.success) {
+            ++succeeded;
+        } else {
+            failures += QString("\n活动%1: %2").arg(result.activityId).arg(result.reason);
+        }
+    }
+    return QString("%1%2个活动，成功%3个，失败%4个").arg(action).arg(results.size()).arg(succeeded)
+               .arg(results.size() - succeeded) + failures;
+}
+
+QList<int> succeededIds(const QList<ReviewResult>& results)
+{
+    QList<int> ids;
+    for (const ReviewResult& result : results) {
+        if (result.success) {
+            ids << result.activityId;
+        }
+    }
+    return ids;
+}
+
+}
+
+adminwidget::adminwidget(const QString& username, int userId, QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::adminwidget)
+    , m_username(username)
+    , m_userId(userId)
+    , m_model(new ActivityModel(this))
 {
     ui->setupUi(this);
+
+    // 管理员看到全部活动；表格为多选，审批按钮作用于所有选中行
+    ui->activityTable->setModel(m_model);
+    m_model->refresh("admin", m_userId);
+
+    connect(ui->activityTable->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &adminwidget::onSelectionChanged);
+    connect(ui->refreshButton, &QPushButton::clicked, this, [this]() { m_model->refresh("admin", m_userId); });
+    connect(ui->approveButton, &QPushButton::clicked, this, &adminwidget::onApproveClicked);
+    connect(ui->rejectButton, &QPushButton::clicked, this, &adminwidget::onRejectClicked);
+    connect(ui->importButton, &QPushButton::clicked, this, &adminwidget::onImportClicked);
 }
 
 adminwidget::~adminwidget()
 {
     delete ui;
 }
+
+QList<int> adminwidget::selectedActivityIds() const
+{
+    QList<int> ids;
+    for (const QModelIndex& index : ui->activityTable->selectionModel()->selectedRows()) {
+        const int activityId = m_model->getActivityId(index.row());
+        if (activityId > 0) {
+            ids << activityId;
+        }
+    }
+    return ids;
+}
+
+void adminwidget::onSelectionChanged()
+{
+    const bool hasSelection = ui->activityTable->selectionModel()->hasSelection();
+    ui->approveButton->setEnabled(hasSelection);
+    ui->rejectButton->setEnabled(hasSelection);
+}
+
+void adminwidget::onApproveClicked()
+{
+    const QList<int> ids = selectedActivityIds();
+    if (ids.isEmpty()) {
+        return;
+    }
+
+    const QList<ReviewResult> results = DatabaseManager::instance().approveActivities(ids, m_userId);
+    m_model->applyStatusChange(succeededIds(results), "approved");
+    QMessageBox::information(this, "审批", reviewSummary("审批通过", results));
+}
+
+void adminwidget::onRejectClicked()
+{
+    const QList<int> ids = selectedActivityIds();
+    if (ids.isEmpty()) {
+        return;
+    }
+
+    bool ok = false;
+    const QString reason = QInputDialog::getText(this, "拒绝", QString("拒绝选中的%1个活动，原因：").arg(ids.size()),
+                                                 QLineEdit::Normal, QString(), &ok);
+    if (!ok) {
+        return;
+    }
+
+    const QList<ReviewResult> results = DatabaseManager::instance().rejectActivities(ids, m_userId, reason);
+    m_model->applyStatusChange(succeededIds(results), "rejected");
+    QMessageBox::information(this, "审批", reviewSummary("拒绝", results));
+}
+
+void adminwidget::onImportClicked()
+{
+    const QStringList targets = { "用户", "活动" };
+    bool ok = false;
+    const QString target = QInputDialog::getItem(this, "批量导入", "导入内容：", targets, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    const QString fileName = QFileDialog::getOpenFileName(this, "选择CSV文件", QString(), "CSV文件 (*.csv)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    const CsvImporter::Target importTarget = target == targets.first() ? CsvImporter::Target::Users
+                                                                      : CsvImporter::Target::Activities;
+
+    // 先试运行校验，管理员看过结果再确认写入（正式导入用新的导入器，重新加载已有用户名）
+    CsvImporter dryRun(importTarget, fileName);
+    dryRun.setDryRun(true);
+    CsvImportResult result = dryRun.run();
+    if (result.importedRows == 0) {
+        QMessageBox::warning(this, "批量导入", importSummary(result));
+        return;
+    }
+
+    const QString question = importSummary(result) + "\n\n是否导入校验通过的行？";
+    if (QMessageBox::question(this, "批量导入", question) != QMessageBox::Yes) {
+        return;
+    }
+
+    CsvImporter importer(importTarget, fileName);
+    result = importer.run();
+    if (result.failedRows == 0 && result.errors.isEmpty()) {
+        QMessageBox::information(this, "批量导入", importSummary(result));
+    } else {
+        QMessageBox::warning(this, "批量导入", importSummary(result));
+    }
+}
@@ -7,16 +7,31 @@ namespace Ui {
 class adminwidget;
 }
 
+class ActivityModel;
+
 class adminwidget : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit adminwidget(QWidget *parent = nullptr);
+    adminwidget(const QString& username, int userId, QWidget *parent = nullptr);
     ~adminwidget();
 
+private slots:
+    // 批量导入：选择用户或活动CSV文件，先试运行校验，确认后正式导入
+    void onImportClicked();
+    // 批量审批：对所有选中的活动调用一次，成功的行就地更新状态，逐条列出失败原因
+    void onApproveClicked();
+    void onRejectClicked();
+    void onSelectionChanged();
+
 private:
+    QList<int> selectedActivityIds() const;
+
     Ui::adminwidget *ui;
+    QString m_username;
+    int m_userId;
+    ActivityModel *m_model;
 };
 
 #endif // ADMINWIDGET_H
@@ -0,0 +1,304 @@
+//【阶段21：2024-06-19】在线备份实现
+// 使用SQLite在线备份API需要在qmake时加 CONFIG+=sqlite_direct，并保证Qt的SQLite驱动
+// 与链接的libsqlite3是同一份（-system-sqlite 构建的Qt），否则句柄不能混用
+
+#include "backupmanager.h"
+#include "databasemanager.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QTimer>
+#include <QThread>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QtConcurrent>
+#include <QDebug>
+
+#ifdef CAMPUS_SQLITE_DIRECT
+#include <sqlite3.h>
+#endif
+
+namespace {
+
+// 每步复制的页面数（默认页大小4KB，即每步约400KB）及两步之间让出的时间
+const int kPagesPerStep = 100;
+const int kStepPauseMs = 5;
+
+// 源库被其他连接写入会使分步复制从头开始；写入不停时超过此次数就一次复制剩余全部页面
+const int kMaxRestarts = 10;
+
+const char *kGenerationFormat = "yyyyMMdd_HHmmss";
+
+QAtomicInt g_connectionSerial;
+
+QString nextConnectionName()
+{
+    return QString("backup_%1").arg(g_connectionSerial.fetchAndAddRelaxed(1));
+}
+
+#ifdef CAMPUS_SQLITE_DIRECT
+sqlite3 *sqliteHandle(const QSqlDatabase& db)
+{
+    const QVariant handle = db.driver()->handle();
+    if (handle.isValid() && qstrcmp(handle.typeName(), "sqlite3*") == 0) {
+        return *static_cast<sqlite3 *const *>(handle.constData());
+    }
+    return nullptr;
+}
+#endif
+
+}
+
+BackupManager::BackupManager(const QString& backupDir, QObject *parent)
+    : QObject(parent)
+    , m_backupDir(backupDir.isEmpty() ? defaultBackupDir() : backupDir)
+    , m_keepGenerations(7)
+    , m_timer(nullptr)
+{
+    connect(&m_watcher, &QFutureWatcher<BackupResult>::finished, this, [this]() {
+        emit backupFinished(m_watcher.result());
+    });
+}
+
+QString BackupManager::defaultBackupDir()
+{
+    QFileInfo dbFile(DatabaseManager::instance().database().databaseName());
+    return dbFile.absoluteDir().filePath("backups");
+}
+
+void BackupManager::startSchedule(int intervalMinutes)
+{
+    if (intervalMinutes <= 0) {
+        if (m_timer) {
+            m_timer->stop();
+        }
+        return;
+    }
+
+    if (!m_timer) {
+        m_timer = new QTimer(this);
+        connect(m_timer, &QTimer::timeout, this, &BackupManager::startBackup);
+    }
+
+    m_timer->start(intervalMinutes * 60 * 1000);
+}
+
+bool BackupManager::startBackup()
+{
+    if (m_watcher.isRunning()) {
+        qDebug() << "Backup already in progress";
+        return false;
+    }
+
+    const QStringList files = sourceFiles();
+    const QString backupDir = m_backupDir;
+    const int keep = m_keepGenerations;
+    m_watcher.setFuture(QtConcurrent::run([files, backupDir, keep]() {
+        return backupFiles(files, backupDir, keep);
+    }));
+    return true;
+}
+
+BackupResult BackupManager::runBackup()
+{
+    return backupFiles(sourceFiles(), m_backupDir, m_keepGenerations);
+}
+
+bool BackupManager::snapshotDatabase(const QString& source, const QString& target, QString& error)
+{
+    BackupResult result;
+    const bool ok = copyDatabase(source, target, result);
+    error = result.error;
+    return ok;
+}
+
+QStringList BackupManager::sourceFiles()
+{
+    QStringList files = { DatabaseManager::instance().database().databaseName() };
+    for (const TermDatabase& term : DatabaseManager::instance().termDatabases()) {
+        files << term.fileName;
+    }
+    return files;
+}
+
+BackupResult BackupManager::backupFiles(const QStringList& files, const QString& backupDir, int keepGenerations)
+{
+    BackupResult result;
+#ifdef CAMPUS_SQLITE_DIRECT
+    result.directBackup = true;
+#else
+    qWarning() << "Online backup API not available (build without CONFIG+=sqlite_direct),"
+               << "falling back to VACUUM INTO which holds a read lock for the whole copy";
+#endif
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 先写入临时目录，全部复制并校验通过后再改名为正式的一代
+    const QString generation = QDateTime::currentDateTime().toString(kGenerationFormat);
+    QDir root(backupDir);
+    const QString partialName = generation + ".partial";
+    if (!root.mkpath(partialName)) {
+        result.error = "无法创建备份目录: " + root.filePath(partialName);
+        return result;
+    }
+    QDir partial(root.filePath(partialName));
+
+    for (const QString& source : files) {
+        const QString target = partial.filePath(QFileInfo(source).fileName());
+        if (!copyDatabase(source, target, result) || !verifyDatabase(target, result.error)) {
+            partial.removeRecursively();
+            return result;
+        }
+        result.bytes += QFileInfo(target).size();
+        ++result.files;
+    }
+
+    if (!root.rename(partialName, generation)) {
+        result.error = "无法完成备份目录: " + root.filePath(generation);
+        partial.removeRecursively();
+        return result;
+    }
+
+    result.directory = root.filePath(generation);
+    result.removedGenerations = rotate(backupDir, keepGenerations);
+    result.elapsedMs = timer.elapsed();
+    result.ok = true;
+
+    if (result.directBackup) {
+        qDebug() << "Backup" << result.directory << ":" << result.files << "files," << result.bytes << "bytes,"
+                 << result.steps << "steps," << result.restarts << "restarts in" << result.elapsedMs
+                 << "ms, worst stall" << result.worstStallMs << "ms";
+    } else {
+        qDebug() << "Backup" << result.directory << ":" << result.files << "files," << result.bytes << "bytes"
+                 << "with VACUUM INTO in" << result.elapsedMs << "ms";
+    }
+    return result;
+}
+
+bool BackupManager::copyDatabase(const QString& source, const QString& target, BackupResult& result)
+{
+    const QString sourceName = nextConnectionName();
+    const QString targetName = nextConnectionName();
+    bool ok = false;
+    {
+        QSqlDatabase src = QSqlDatabase::addDatabase("QSQLITE", sourceName);
+        src.setDatabaseName(source);
+        src.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+
+        if (!src.open()) {
+            result.error = src.lastError().text();
+        } else {
+#ifdef CAMPUS_SQLITE_DIRECT
+            QSqlDatabase dst = QSqlDatabase::addDatabase("QSQLITE", targetName);
+            dst.setDatabaseName(target);
+            sqlite3 *srcHandle = sqliteHandle(src);
+            sqlite3 *dstHandle = dst.open() ? sqliteHandle(dst) : nullptr;
+            sqlite3_backup *backup = (srcHandle && dstHandle)
+                ? sqlite3_backup_init(dstHandle, "main", srcHandle, "main") : nullptr;
+
+            if (!backup) {
+                result.error = dstHandle ? QString::fromUtf8(sqlite3_errmsg(dstHandle)) : dst.lastError().text();
+            } else {
+                // 每步只在复制期间持有源库的读锁，步与步之间写入方可以提交；
+                // 其他连接的写入会使备份从头开始（剩余页数变多），重启过多时最后一步复制全部剩余页面
+                QElapsedTimer stepTimer;
+                int rc = SQLITE_OK;
+                int lastRemaining = -1;
+                do {
+                    const int pages = result.restarts >= kMaxRestarts ? -1 : kPagesPerStep;
+                    stepTimer.start();
+                    rc = sqlite3_backup_step(backup, pages);
+                    result.worstStallMs = qMax(result.worstStallMs, stepTimer.elapsed());
+                    ++result.steps;
+
+                    const int remaining = sqlite3_backup_remaining(backup);
+                    if (lastRemaining >= 0 && remaining > lastRemaining) {
+                        ++result.restarts;
+                    }
+                    lastRemaining = remaining;
+
+                    if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+                        QThread::msleep(kStepPauseMs);
+                    }
+                } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+                sqlite3_backup_finish(backup);
+                ok = (rc == SQLITE_DONE);
+                if (!ok) {
+                    result.error = QString::fromUtf8(sqlite3_errstr(rc));
+                }
+            }
+            dst.close();
+#else
+            // 没有直接访问SQLite的条件时用一条语句整体复制，读锁在整个复制期间持有，
+            // 不分步，也就没有可以统计的单步阻塞时间
+            QSqlQuery query(src);
+            query.prepare("VACUUM INTO ?");
+            query.addBindValue(target);
+            ok = query.exec();
+            if (!ok) {
+                result.error = query.lastError().text();
+            }
+#endif
+        }
+        src.close();
+    }
+    QSqlDatabase::removeDatabase(sourceName);
+    QSqlDatabase::removeDatabase(targetName);
+
+    if (!ok) {
+        qDebug() << "Failed to back up" << source << ":" << result.error;
+    }
+    return ok;
+}
+
+bool BackupManager::verifyDatabase(const QString& fileName, QString& error)
+{
+    const QString connectionName = nextConnectionName();
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(fileName);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY");
+
+        if (!db.open()) {
+            error = db.lastError().text();
+        } else {
+            QSqlQuery query(db);
+            if (!query.exec("PRAGMA integrity_check") || !query.next()) {
+                error = query.lastError().text();
+            } else if (query.value(0).toString() != "ok") {
+                error = "完整性检查失败: " + query.value(0).toString();
+            } else {
+                ok = true;
+            }
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return ok;
+}
+
+QStringList BackupManager::rotate(const QString& backupDir, int keepGenerations)
+{
+    // 目录名即时间，按名称倒序就是从新到旧；只处理符合命名格式的目录
+    QDir root(backupDir);
+    const QStringList generations = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name | QDir::Reversed);
+
+    QStringList removed;
+    int kept = 0;
+    for (const QString& name : generations) {
+        if (!QDateTime::fromString(name, kGenerationFormat).isValid()) {
+            continue;
+        }
+        if (++kept > keepGenerations && QDir(root.filePath(name)).removeRecursively()) {
+            removed << name;
+        }
+    }
+    return removed;
+}
@@ -0,0 +1,82 @@
+#ifndef BACKUPMANAGER_H
+#define BACKUPMANAGER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFutureWatcher>
+
+class QTimer;
+
+//【阶段21：2024-06-19】在线增量备份：后台连接分步复制，校验后按代轮换
+
+// 一次备份的结果
+struct BackupResult
+{
+    bool ok = false;
+    QString error;
+    QString directory;          // 本代备份目录
+    int files = 0;              // 主库及各学期分片
+    qint64 bytes = 0;
+    // 以下三项只在分步复制（directBackup）时有意义；VACUUM INTO 整体复制，不分步也不统计阻塞
+    int steps = 0;              // 分步复制的步数
+    int restarts = 0;           // 复制期间源库被写入而从头开始的次数
+    qint64 worstStallMs = 0;    // 单步持有读锁的最长时间，即对写入方造成的最长阻塞
+    qint64 elapsedMs = 0;
+    bool directBackup = false;  // 是否使用sqlite3_backup（否则为VACUUM INTO）
+    QStringList removedGenerations;
+};
+
+/**
+ * @brief 在线备份管理类
+ * 在后台线程中用独立的只读连接复制数据库，不占用界面线程的连接：
+ * 定义了CAMPUS_SQLITE_DIRECT时使用SQLite在线备份API，每步复制少量页面后释放锁并让出，
+ * 报名等写操作只会在单步内等待；源库持续被写入导致反复重启时，超过次数上限后一次复制剩余页面。
+ * 否则退化为一条 VACUUM INTO 语句，整个复制期间持有读锁，并在每次备份时输出警告。
+ * 每代备份为备份目录下一个 yyyyMMdd_HHmmss 子目录，完成后做完整性检查，只保留最近N代。
+ */
+class BackupManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BackupManager(const QString& backupDir, QObject *parent = nullptr);
+
+    // 保留的备份代数
+    void setKeepGenerations(int generations) { m_keepGenerations = qMax(1, generations); }
+
+    // 定时备份（intervalMinutes <= 0 表示停止）
+    void startSchedule(int intervalMinutes);
+
+    // 在后台线程开始一次备份，已有备份在进行时返回false
+    bool startBackup();
+
+    // 在调用线程中阻塞执行一次备份（命令行使用）
+    BackupResult runBackup();
+
+    // 默认备份目录：数据库所在目录下的backups子目录
+    static QString defaultBackupDir();
+
+    // 通过SQLite连接把单个数据库复制为一致的快照（包含WAL中已提交的内容），target不能已存在
+    static bool snapshotDatabase(const QString& source, const QString& target, QString& error);
+
+signals:
+    void backupFinished(const BackupResult& result);
+
+private:
+    // 需要备份的数据库文件（主库及已附加的学期分片），在主线程中收集
+    static QStringList sourceFiles();
+
+    // 在工作线程中执行，只使用自己创建的连接
+    static BackupResult backupFiles(const QStringList& files, const QString& backupDir, int keepGenerations);
+    static bool copyDatabase(const QString& source, const QString& target, BackupResult& result);
+    static bool verifyDatabase(const QString& fileName, QString& error);
+    static QStringList rotate(const QString& backupDir, int keepGenerations);
+
+    QString m_backupDir;
+    int m_keepGenerations;
+    QTimer *m_timer;
+    QFutureWatcher<BackupResult> m_watcher;
+};
+
+#endif // BACKUPMANAGER_H
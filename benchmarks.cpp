@@ -0,0 +1,310 @@
+//【阶段18：2024-06-12】性能基准实现
+// 基准会向当前数据库写入测试数据，未指定--database时由main在临时目录的新数据库上运行
+
+#include "benchmarks.h"
+#include "databasemanager.h"
+#include "reportexporter.h"
+#include "rowtypes.h"
+#include "csvwriter.h"
+#include <QTextStream>
+#include <QFile>
+#include <QStringConverter>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QDebug>
+
+namespace {
+
+const int kBenchOrganizers = 20;
+const int kBenchActivitiesPerOrganizer = 50;
+const int kBenchStudents = 2000;
+const int kBenchEnrollmentsPerActivity = 200;
+const int kBenchRounds = 5;
+
+// 数据库中没有基准数据时生成：20个发起人×50个活动，每个活动200条报名
+bool seedBenchmarkData(QTextStream& out)
+{
+    QSqlDatabase db = DatabaseManager::instance().database();
+    QSqlQuery query(db);
+
+    if (query.exec("SELECT COUNT(*) FROM users WHERE username LIKE 'bench_%'") && query.next()
+        && query.value(0).toInt() > 0) {
+        return true;
+    }
+
+    out << "生成基准数据...\n";
+    out.flush();
+
+    if (!db.transaction()) {
+        return false;
+    }
+
+    QList<int> organizerIds;
+    QList<int> studentIds;
+    query.prepare("INSERT INTO users (username, password, role) VALUES (?, 'bench', ?)");
+    for (int i = 0; i < kBenchOrganizers; ++i) {
+        query.addBindValue(QString("bench_org_%1").arg(i));
+        query.addBindValue("organizer");
+        query.exec();
+        organizerIds << query.lastInsertId().toInt();
+    }
+    for (int i = 0; i < kBenchStudents; ++i) {
+        query.addBindValue(QString("bench_stu_%1").arg(i));
+        query.addBindValue("student");
+        query.exec();
+        studentIds << query.lastInsertId().toInt();
+    }
+
+    QSqlQuery activityInsert(db);
+    activityInsert.prepare(R"(
+        INSERT INTO activities (title, description, organizer_id, start_time, end_time,
+                                max_participants, current_participants, category, status)
+        VALUES (?, '', ?, ?, ?, ?, ?, 'bench', 'approved')
+    )");
+    QSqlQuery enrollInsert(db);
+    enrollInsert.prepare("INSERT INTO enrollments (user_id, activity_id, status) VALUES (?, ?, 'enrolled')");
+
+    const QDateTime base = QDateTime::currentDateTime().addDays(30);
+    int serial = 0;
+    for (int organizerId : organizerIds) {
+        for (int i = 0; i < kBenchActivitiesPerOrganizer; ++i, ++serial) {
+            const QDateTime start = base.addSecs(serial * 3600);
+            activityInsert.addBindValue(QString("基准活动 %1").arg(serial));
+            activityInsert.addBindValue(organizerId);
+            activityInsert.addBindValue(DatabaseManager::formatTime(start));
+            activityInsert.addBindValue(DatabaseManager::formatTime(start.addSecs(3600)));
+            activityInsert.addBindValue(kBenchEnrollmentsPerActivity);
+            activityInsert.addBindValue(kBenchEnrollmentsPerActivity);
+            if (!activityInsert.exec()) {
+                qDebug() << "Failed to seed activity:" << activityInsert.lastError().text();
+                db.rollback();
+                return false;
+            }
+            const int activityId = activityInsert.lastInsertId().toInt();
+
+            for (int j = 0; j < kBenchEnrollmentsPerActivity; ++j) {
+                enrollInsert.addBindValue(studentIds.at((serial * 7 + j) % studentIds.size()));
+                enrollInsert.addBindValue(activityId);
+                enrollInsert.exec();
+            }
+        }
+    }
+
+    return db.commit();
+}
+
+}
+
+namespace Benchmarks
+{
+
+int runReportExport(QTextStream& out)
+{
+    if (!seedBenchmarkData(out)) {
+        out << "生成基准数据失败\n";
+        return 1;
+    }
+
+    QTemporaryDir outputRoot;
+    if (!outputRoot.isValid()) {
+        out << "无法创建临时目录\n";
+        return 1;
+    }
+
+    // 1、2、4…，最后一轮使用全部核心
+    const int maxThreads = QThread::idealThreadCount();
+    QList<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts << threads;
+    }
+    threadCounts << maxThreads;
+
+    qint64 baselineMs = 0;
+    out << "线程数,文件数,行数,耗时(ms),加速比\n";
+    for (int threads : threadCounts) {
+        ReportExporter exporter(ReportExporter::Partition::ByActivity,
+                                outputRoot.filePath(QString("threads_%1").arg(threads)));
+        exporter.setMaxThreads(threads);
+        const ReportExportResult result = exporter.run();
+
+        if (baselineMs == 0) {
+            baselineMs = qMax<qint64>(1, result.elapsedMs);
+        }
+        out << threads << ',' << result.files.size() << ',' << result.totalRows << ','
+            << result.elapsedMs << ',' << QString::number(double(baselineMs) / qMax<qint64>(1, result.elapsedMs), 'f', 2)
+            << '\n';
+        out.flush();
+    }
+
+    return 0;
+}
+
+int runRowMapping(QTextStream& out)
+{
+    if (!seedBenchmarkData(out)) {
+        out << "生成基准数据失败\n";
+        return 1;
+    }
+
+    QSqlDatabase db = DatabaseManager::instance().database();
+    const QString sql = DatabaseManager::instance().fanOutSql(
+        selectSql<EnrollmentRow>("WHERE e.status = 'enrolled'"), "enrolled_at DESC");
+
+    // 原实现：按魔法下标读取，每行构造一个QStringList
+    auto positional = [&db, &sql]() {
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        query.exec(sql);
+        QList<QStringList> rows;
+        while (query.next()) {
+            QStringList row;
+            row << QString::number(query.value(0).toInt());
+            row << query.value(1).toString();
+            row << query.value(2).toString();
+            row << query.value(3).toString();
+            row << query.value(4).toString();
+            row << query.value(5).toString();
+            rows.append(row);
+        }
+        return qsizetype(rows.size());
+    };
+
+    // 类型化行映射：按编译期列下标读入结构体，连续存放
+    auto typed = [&db, &sql]() {
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        query.exec(sql);
+        return qsizetype(fetchRows<EnrollmentRow>(query).size());
+    };
+
+    auto measure = [](const auto& run, qsizetype& rows) {
+        qint64 best = -1;
+        for (int i = 0; i < kBenchRounds; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            rows = run();
+            const qint64 elapsed = timer.nsecsElapsed();
+            best = (best < 0 || elapsed < best) ? elapsed : best;
+        }
+        return best;
+    };
+
+    qsizetype positionalRows = 0;
+    qsizetype typedRows = 0;
+    const qint64 positionalNs = measure(positional, positionalRows);
+    const qint64 typedNs = measure(typed, typedRows);
+
+    out << "实现,行数,最佳耗时(ms),行/秒\n";
+    out << "positional," << positionalRows << ',' << QString::number(positionalNs / 1e6, 'f', 2) << ','
+        << qRound64(positionalRows * 1e9 / qMax<qint64>(1, positionalNs)) << '\n';
+    out << "typed," << typedRows << ',' << QString::number(typedNs / 1e6, 'f', 2) << ','
+        << qRound64(typedRows * 1e9 / qMax<qint64>(1, typedNs)) << '\n';
+    return 0;
+}
+
+
+int runCsvWriter(QTextStream& out)
+{
+    // 内存中生成报表行，只测序列化和写文件；每20行有一个字段含逗号、引号或换行
+    const int rowCount = kBenchOrganizers * kBenchActivitiesPerOrganizer * kBenchEnrollmentsPerActivity;
+    const QStringList specials = { "，逗号,分隔", "带\"引号\"的标题", "跨行\n标题" };
+    std::vector<EnrollmentRow> rows(rowCount);
+    const QString enrolledAt = DatabaseManager::formatTime(QDateTime::currentDateTime());
+    for (int i = 0; i < rowCount; ++i) {
+        EnrollmentRow& row = rows[i];
+        row.activityId = i / kBenchEnrollmentsPerActivity + 1;
+        row.activityTitle = (i % 20 == 0) ? specials.at((i / 20) % specials.size())
+                                          : QString("基准活动 %1").arg(row.activityId);
+        row.organizerName = QString("bench_org_%1").arg(row.activityId % kBenchOrganizers);
+        row.username = QString("bench_stu_%1").arg(i % kBenchStudents);
+        row.enrolledAt = enrolledAt;
+        row.status = "enrolled";
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        out << "无法创建临时目录\n";
+        return 1;
+    }
+
+    // 原实现：每行QString::arg拼接、逐字段replace转义，经QTextStream逐行转码
+    auto legacy = [&rows, &dir]() {
+        QFile file(dir.filePath("legacy.csv"));
+        file.open(QIODevice::WriteOnly | QIODevice::Text);
+        QTextStream stream(&file);
+        stream.setEncoding(QStringConverter::Utf8);
+        stream << "\xEF\xBB\xBF";
+        stream << "活动ID,活动名称,发起人,报名学生,报名时间,状态\n";
+        for (const EnrollmentRow& row : rows) {
+            QString activityTitleEscaped = row.activityTitle;
+            activityTitleEscaped.replace("\"", "\"\"");
+            QString organizerNameEscaped = row.organizerName;
+            organizerNameEscaped.replace("\"", "\"\"");
+            QString usernameEscaped = row.username;
+            usernameEscaped.replace("\"", "\"\"");
+            stream << QString("%1,\"%2\",\"%3\",\"%4\",\"%5\",\"%6\"\n")
+                          .arg(row.activityId)
+                          .arg(activityTitleEscaped)
+                          .arg(organizerNameEscaped)
+                          .arg(usernameEscaped)
+                          .arg(row.enrolledAt)
+                          .arg(row.status);
+        }
+        stream.flush();
+        return file.size();
+    };
+
+    auto fast = [&rows, &dir]() {
+        QFile file(dir.filePath("fast.csv"));
+        file.open(QIODevice::WriteOnly);
+        CsvWriter writer(&file);
+        writer.writeBom();
+        writer.writeRow({ "活动ID", "活动名称", "发起人", "报名学生", "报名时间", "状态" });
+        for (const EnrollmentRow& row : rows) {
+            writer.writeField(row.activityId);
+            writer.writeField(row.activityTitle);
+            writer.writeField(row.organizerName);
+            writer.writeField(row.username);
+            writer.writeField(row.enrolledAt);
+            writer.writeField(row.status);
+            writer.endRow();
+        }
+        writer.flush();
+        return file.size();
+    };
+
+    auto measure = [](const auto& run, qint64& bytes) {
+        qint64 best = -1;
+        for (int i = 0; i < kBenchRounds; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            bytes = run();
+            const qint64 elapsed = timer.nsecsElapsed();
+            best = (best < 0 || elapsed < best) ? elapsed : best;
+        }
+        return best;
+    };
+
+    qint64 legacyBytes = 0;
+    qint64 fastBytes = 0;
+    const qint64 legacyNs = measure(legacy, legacyBytes);
+    const qint64 fastNs = measure(fast, fastBytes);
+
+    auto megabytesPerSecond = [](qint64 bytes, qint64 ns) {
+        return QString::number(bytes / 1048576.0 / (qMax<qint64>(1, ns) / 1e9), 'f', 1);
+    };
+
+    out << "实现,行数,字节数,最佳耗时(ms),MB/s\n";
+    out << "legacy," << rowCount << ',' << legacyBytes << ',' << QString::number(legacyNs / 1e6, 'f', 2) << ','
+        << megabytesPerSecond(legacyBytes, legacyNs) << '\n';
+    out << "csv-writer," << rowCount << ',' << fastBytes << ',' << QString::number(fastNs / 1e6, 'f', 2) << ','
+        << megabytesPerSecond(fastBytes, fastNs) << '\n';
+    return 0;
+}
+
+}
@@ -0,0 +1,20 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+class QTextStream;
+
+//【阶段18：2024-06-12】命令行性能基准，结果输出到标准输出
+
+namespace Benchmarks
+{
+    // 分区报表导出：依次使用1、2、4…个线程导出同一数据集，输出耗时和加速比
+    int runReportExport(QTextStream& out);
+
+    // 报名报表查询：按下标读QVariant拼QStringList 与 类型化行映射 的对比
+    int runRowMapping(QTextStream& out);
+
+    // CSV写出：原QString::arg + QTextStream实现 与 CsvWriter 的吞吐量（MB/s）对比
+    int runCsvWriter(QTextStream& out);
+}
+
+#endif // BENCHMARKS_H
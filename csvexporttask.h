@@ -4,9 +4,13 @@
 #include <QString>
 #include <QList>
 #include <QStringList>
+#include <vector>
+#include "rowtypes.h"
 
 //【阶段11：2024-05-30】实现CSV导出任务类
 //【阶段14：2024-06-02】简化导出功能，直接在主线程执行，避免线程安全问题
+//【阶段19：2024-06-14】查询结果改为类型化的EnrollmentRow
+//【阶段23：2024-06-24】写文件改用CsvWriter，字段只在需要时加引号
 
 /**
  * @brief CSV导出任务类
@@ -25,7 +29,7 @@ public:
 
 private:
     QString m_fileName;
-    QList<QStringList> m_dataRows;  // 存储查询到的数据
+    std::vector<EnrollmentRow> m_dataRows;  // 存储查询到的数据
 };
 
 #endif // CSVEXPORTTASK_H
@@ -0,0 +1,359 @@
+//【阶段15：2024-06-05】实现流式CSV导入，分块事务提交，逐行错误报告
+
+#include "csvimporter.h"
+#include "databasemanager.h"
+#include <QFile>
+#include <QTextStream>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QStringConverter>
+#include <QDebug>
+
+namespace {
+
+const QStringList kUserColumns = { "username", "password", "role" };
+const QStringList kActivityColumns = { "title", "description", "organizer", "start_time",
+                                       "end_time", "max_participants", "category" };
+
+}
+
+CsvImporter::CsvImporter(Target target, const QString& fileName)
+    : m_target(target)
+    , m_fileName(fileName)
+    , m_dryRun(false)
+    , m_chunkSize(1000)
+{
+}
+
+bool CsvImporter::readRecord(QTextStream& in, QStringList& fields, int& lineNo)
+{
+    fields.clear();
+    if (in.atEnd()) {
+        return false;
+    }
+
+    QString current;
+    bool inQuotes = false;
+
+    do {
+        QString line = in.readLine();
+        ++lineNo;
+
+        for (int i = 0; i < line.size(); ++i) {
+            const QChar ch = line.at(i);
+            if (inQuotes) {
+                if (ch == '"') {
+                    if (i + 1 < line.size() && line.at(i + 1) == '"') {
+                        current += '"';
+                        ++i;
+                    } else {
+                        inQuotes = false;
+                    }
+                } else {
+                    current += ch;
+                }
+            } else if (ch == '"') {
+                inQuotes = true;
+            } else if (ch == ',') {
+                fields << current;
+                current.clear();
+            } else {
+                current += ch;
+            }
+        }
+
+        // 引号未闭合说明字段内包含换行，继续读取下一物理行
+        if (inQuotes) {
+            current += '\n';
+        }
+    } while (inQuotes && !in.atEnd());
+
+    fields << current;
+    return true;
+}
+
+bool CsvImporter::preload(CsvImportResult& result)
+{
+    QSqlQuery query(DatabaseManager::instance().database());
+    query.setForwardOnly(true);
+
+    if (m_target == Target::Users) {
+        // 一次性加载已有用户名，用于重复检测（试运行时无法依赖UNIQUE约束）
+        if (!query.exec("SELECT username FROM users")) {
+            result.errors.append({ 0, "加载用户列表失败: " + query.lastError().text() });
+            return false;
+        }
+        while (query.next()) {
+            m_usernames.insert(query.value(0).toString());
+        }
+    } else {
+        // 一次性加载发起人映射，替代createActivity中逐条按用户名查询
+        if (!query.exec("SELECT id, username FROM users WHERE role = 'organizer'")) {
+            result.errors.append({ 0, "加载发起人列表失败: " + query.lastError().text() });
+            return false;
+        }
+        while (query.next()) {
+            m_organizerIds.insert(query.value(1).toString(), query.value(0).toInt());
+        }
+    }
+
+    return true;
+}
+
+bool CsvImporter::resolveColumns(const QStringList& header, CsvImportResult& result)
+{
+    m_columns.clear();
+    for (int i = 0; i < header.size(); ++i) {
+        QString name = header.at(i).trimmed().toLower();
+        // 去掉Excel导出的UTF-8 BOM
+        if (i == 0 && name.startsWith(QChar(0xFEFF))) {
+            name.remove(0, 1);
+        }
+        m_columns.insert(name, i);
+    }
+
+    const QStringList& required = (m_target == Target::Users) ? kUserColumns : kActivityColumns;
+    for (const QString& column : required) {
+        if (column == "description" || column == "category") {
+            continue; // 可选列
+        }
+        if (!m_columns.contains(column)) {
+            result.errors.append({ 1, "缺少必需列: " + column });
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QString CsvImporter::field(const QStringList& fields, const QString& column) const
+{
+    int index = m_columns.value(column, -1);
+    if (index < 0 || index >= fields.size()) {
+        return QString();
+    }
+    return fields.at(index).trimmed();
+}
+
+QString CsvImporter::validateUser(const QStringList& fields) const
+{
+    const QString username = field(fields, "username");
+    const QString password = field(fields, "password");
+    const QString role = field(fields, "role");
+
+    if (username.isEmpty()) {
+        return "用户名为空";
+    }
+    if (password.isEmpty()) {
+        return "密码为空";
+    }
+    if (role != "admin" && role != "organizer" && role != "student") {
+        return "无效的角色: " + role;
+    }
+    if (m_usernames.contains(username)) {
+        return "用户名已存在: " + username;
+    }
+
+    return QString();
+}
+
+QString CsvImporter::validateActivity(const QStringList& fields, int& organizerId,
+                                      QString& startTime, QString& endTime) const
+{
+    const QString title = field(fields, "title");
+    const QString organizer = field(fields, "organizer");
+
+    if (title.isEmpty()) {
+        return "活动名称为空";
+    }
+
+    auto it = m_organizerIds.constFind(organizer);
+    if (it == m_organizerIds.constEnd()) {
+        return "发起人不存在: " + organizer;
+    }
+    organizerId = it.value();
+
+    QDateTime start = DatabaseManager::parseTime(field(fields, "start_time"));
+    QDateTime end = DatabaseManager::parseTime(field(fields, "end_time"));
+    if (!start.isValid()) {
+        return "开始时间格式无效: " + field(fields, "start_time");
+    }
+    if (!end.isValid()) {
+        return "结束时间格式无效: " + field(fields, "end_time");
+    }
+    if (end <= start) {
+        return "结束时间必须晚于开始时间";
+    }
+    startTime = DatabaseManager::formatTime(start);
+    endTime = DatabaseManager::formatTime(end);
+
+    bool ok = false;
+    int maxParticipants = field(fields, "max_participants").toInt(&ok);
+    if (!ok || maxParticipants <= 0) {
+        return "人数上限无效: " + field(fields, "max_participants");
+    }
+
+    return QString();
+}
+
+CsvImportResult CsvImporter::run()
+{
+    CsvImportResult result;
+    result.dryRun = m_dryRun;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlDatabase db = DatabaseManager::instance().database();
+    if (!db.isOpen()) {
+        result.errors.append({ 0, "数据库未打开" });
+        return result;
+    }
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        result.errors.append({ 0, "无法打开文件: " + file.errorString() });
+        return result;
+    }
+
+    QTextStream in(&file);
+    in.setEncoding(QStringConverter::Utf8);
+
+    int lineNo = 0;
+    QStringList fields;
+    if (!readRecord(in, fields, lineNo) || !resolveColumns(fields, result)) {
+        if (result.errors.isEmpty()) {
+            result.errors.append({ 1, "文件为空" });
+        }
+        return result;
+    }
+
+    if (!preload(result)) {
+        return result;
+    }
+
+    // 预编译插入语句，每行只重新绑定参数
+    QSqlQuery insert(db);
+    if (!m_dryRun) {
+        if (m_target == Target::Users) {
+            insert.prepare("INSERT INTO users (username, password, role) VALUES (?, ?, ?)");
+        } else {
+            insert.prepare(R"(
+                INSERT INTO activities (title, description, organizer_id, start_time, end_time, max_participants, category, status)
+                VALUES (?, ?, ?, ?, ?, ?, ?, 'pending')
+            )");
+        }
+    }
+
+    int rowsInChunk = 0;
+    bool inTransaction = false;
+    // 本块新加入查重集合的用户名，提交失败回滚时一并撤回，否则后面的行会被误判为重复，
+    // 活动也会引用已回滚的发起人ID
+    QStringList chunkUsernames;
+
+    auto commitChunk = [&](int line) {
+        if (inTransaction && !db.commit()) {
+            qDebug() << "Failed to commit import chunk:" << db.lastError().text();
+            db.rollback();
+            for (const QString& username : chunkUsernames) {
+                m_usernames.remove(username);
+                m_organizerIds.remove(username);
+            }
+            result.importedRows -= rowsInChunk;
+            result.failedRows += rowsInChunk;
+            result.errors.append({ line, "分块提交失败，本块已回滚: " + db.lastError().text() });
+        }
+        inTransaction = false;
+        rowsInChunk = 0;
+        chunkUsernames.clear();
+    };
+
+    while (true) {
+        const int recordLine = lineNo + 1;
+        if (!readRecord(in, fields, lineNo)) {
+            break;
+        }
+        if (fields.size() == 1 && fields.first().trimmed().isEmpty()) {
+            continue; // 跳过空行
+        }
+
+        ++result.totalRows;
+
+        QString error;
+        int organizerId = -1;
+        QString startTime;
+        QString endTime;
+        if (m_target == Target::Users) {
+            error = validateUser(fields);
+        } else {
+            error = validateActivity(fields, organizerId, startTime, endTime);
+        }
+
+        if (!error.isEmpty()) {
+            ++result.failedRows;
+            result.errors.append({ recordLine, error });
+            continue;
+        }
+
+        if (m_dryRun) {
+            if (m_target == Target::Users) {
+                m_usernames.insert(field(fields, "username"));
+            }
+            ++result.importedRows;
+            continue;
+        }
+
+        if (!inTransaction) {
+            inTransaction = db.transaction();
+        }
+
+        if (m_target == Target::Users) {
+            insert.addBindValue(field(fields, "username"));
+            insert.addBindValue(field(fields, "password"));
+            insert.addBindValue(field(fields, "role"));
+        } else {
+            insert.addBindValue(field(fields, "title"));
+            insert.addBindValue(field(fields, "description"));
+            insert.addBindValue(organizerId);
+            insert.addBindValue(startTime);
+            insert.addBindValue(endTime);
+            insert.addBindValue(field(fields, "max_participants").toInt());
+            insert.addBindValue(field(fields, "category"));
+        }
+
+        if (!insert.exec()) {
+            ++result.failedRows;
+            result.errors.append({ recordLine, "写入失败: " + insert.lastError().text() });
+            continue;
+        }
+
+        ++result.importedRows;
+        if (m_target == Target::Users) {
+            const QString username = field(fields, "username");
+            m_usernames.insert(username);
+            chunkUsernames.append(username);
+            if (field(fields, "role") == "organizer") {
+                m_organizerIds.insert(username, insert.lastInsertId().toInt());
+            }
+        }
+
+        if (++rowsInChunk >= m_chunkSize) {
+            commitChunk(recordLine);
+        }
+    }
+
+    commitChunk(lineNo);
+
+    // 吞吐量只按实际写入（试运行时为校验通过）的行计算，失败和回滚的行不计入
+    result.elapsedMs = timer.elapsed();
+    result.rowsPerSecond = result.elapsedMs > 0
+        ? result.importedRows * 1000.0 / result.elapsedMs
+        : result.importedRows * 1000.0;
+
+    qDebug() << "Imported" << result.importedRows << "of" << result.totalRows << "rows from" << m_fileName
+             << "in" << result.elapsedMs << "ms (" << result.rowsPerSecond << "rows/s)"
+             << (m_dryRun ? "[dry run]" : "");
+    return result;
+}
@@ -0,0 +1,82 @@
+#ifndef CSVIMPORTER_H
+#define CSVIMPORTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QSet>
+
+class QTextStream;
+
+//【阶段15：2024-06-05】实现用户/活动批量CSV导入，支持分块事务和试运行
+
+// 单行导入错误（行号从1开始，包含表头行）
+struct CsvImportError
+{
+    int line;
+    QString message;
+};
+
+// 导入结果统计
+struct CsvImportResult
+{
+    int totalRows = 0;       // 已读取的数据行数
+    int importedRows = 0;    // 成功写入（试运行时为校验通过）的行数
+    int failedRows = 0;      // 校验或写入失败的行数
+    qint64 elapsedMs = 0;
+    double rowsPerSecond = 0.0;   // 按成功行数计算的吞吐量
+    bool dryRun = false;
+    QList<CsvImportError> errors;
+};
+
+/**
+ * @brief CSV批量导入类
+ * 流式逐条读取CSV记录，按块提交事务；发起人用户名通过一次性预加载的映射解析。
+ * 用户CSV表头：username,password,role
+ * 活动CSV表头：title,description,organizer,start_time,end_time,max_participants,category
+ */
+class CsvImporter
+{
+public:
+    enum class Target {
+        Users,
+        Activities
+    };
+
+    CsvImporter(Target target, const QString& fileName);
+
+    // 试运行：只做校验，不写数据库
+    void setDryRun(bool dryRun) { m_dryRun = dryRun; }
+
+    // 每个事务提交的行数
+    void setChunkSize(int chunkSize) { m_chunkSize = qMax(1, chunkSize); }
+
+    // 执行导入（必须在主线程调用，与DatabaseManager共用连接）
+    CsvImportResult run();
+
+private:
+    // 读取一条CSV记录，支持引号内的逗号、转义引号和换行
+    static bool readRecord(QTextStream& in, QStringList& fields, int& lineNo);
+
+    bool preload(CsvImportResult& result);
+    bool resolveColumns(const QStringList& header, CsvImportResult& result);
+
+    // 校验单行，失败时返回错误信息
+    QString validateUser(const QStringList& fields) const;
+    QString validateActivity(const QStringList& fields, int& organizerId,
+                             QString& startTime, QString& endTime) const;
+
+    QString field(const QStringList& fields, const QString& column) const;
+
+    Target m_target;
+    QString m_fileName;
+    bool m_dryRun;
+    int m_chunkSize;
+
+    QHash<QString, int> m_columns;         // 列名 -> 列下标
+    QHash<QString, int> m_organizerIds;    // 发起人用户名 -> 用户ID
+    QSet<QString> m_usernames;             // 已存在的用户名（含本次导入）
+};
+
+#endif // CSVIMPORTER_H
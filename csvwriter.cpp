@@ -0,0 +1,176 @@
+//【阶段23：2024-06-24】CSV写入器实现
+
+#include "csvwriter.h"
+#include <QIODevice>
+#include <QDebug>
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CSVWRITER_SSE2
+#endif
+
+namespace {
+
+// 按字节检查：UTF-8多字节序列的每个字节都 >= 0x80，不会与ASCII特殊字符混淆
+inline bool isSpecial(char ch)
+{
+    return ch == ',' || ch == '"' || ch == '\n' || ch == '\r';
+}
+
+// 8字节一组：某字节等于c时，(x - 0x01..) & ~x & 0x80.. 在该字节置位
+inline quint64 matchByte(quint64 word, char c)
+{
+    const quint64 ones = 0x0101010101010101ULL;
+    const quint64 x = word ^ (ones * quint8(c));
+    return (x - ones) & ~x & (ones * 0x80);
+}
+
+}
+
+CsvWriter::CsvWriter(QIODevice *device, qsizetype blockSize)
+    : m_device(device)
+    , m_blockSize(qMax<qsizetype>(4096, blockSize))
+    , m_encoder(QStringEncoder::Utf8)
+    , m_rowStart(true)
+    , m_written(0)
+    , m_error(false)
+{
+    m_buffer.reserve(m_blockSize + 4096);
+}
+
+CsvWriter::~CsvWriter()
+{
+    flush();
+}
+
+bool CsvWriter::needsQuoting(const char *data, qsizetype size)
+{
+    qsizetype i = 0;
+
+#ifdef CSVWRITER_SSE2
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, comma), _mm_cmpeq_epi8(chunk, quote)),
+                                          _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)));
+        if (_mm_movemask_epi8(hits) != 0) {
+            return true;
+        }
+    }
+#endif
+
+    for (; i + 8 <= size; i += 8) {
+        quint64 word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if (matchByte(word, ',') | matchByte(word, '"') | matchByte(word, '\n') | matchByte(word, '\r')) {
+            return true;
+        }
+    }
+
+    for (; i < size; ++i) {
+        if (isSpecial(data[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CsvWriter::beginField()
+{
+    if (!m_rowStart) {
+        m_buffer.append(',');
+    }
+    m_rowStart = false;
+}
+
+void CsvWriter::writeBom()
+{
+    m_buffer.append("\xEF\xBB\xBF", 3);
+}
+
+void CsvWriter::writeField(const QString& value)
+{
+    beginField();
+    if (value.isEmpty()) {
+        return;
+    }
+
+    // 先按最坏情况扩展缓冲区，直接编码到末尾，再截到实际长度
+    const qsizetype start = m_buffer.size();
+    m_buffer.resize(start + m_encoder.requiredSpace(value.size()));
+    char *end = m_encoder.appendToBuffer(m_buffer.data() + start, value);
+    const qsizetype length = end - (m_buffer.constData() + start);
+    m_buffer.resize(start + length);
+
+    // 绝大多数字段不含特殊字符，已经是最终结果
+    if (needsQuoting(m_buffer.constData() + start, length)) {
+        m_scratch.resize(length);
+        std::memcpy(m_scratch.data(), m_buffer.constData() + start, length);
+        m_buffer.resize(start);
+        appendQuoted(m_scratch.constData(), m_scratch.size());
+    }
+}
+
+void CsvWriter::writeField(qint64 value)
+{
+    beginField();
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_buffer.append(digits, result.ptr - digits);
+}
+
+void CsvWriter::writeRow(const QStringList& fields)
+{
+    for (const QString& field : fields) {
+        writeField(field);
+    }
+    endRow();
+}
+
+void CsvWriter::appendQuoted(const char *data, qsizetype size)
+{
+    m_buffer.append('"');
+    const char *segment = data;
+    const char *last = data + size;
+    for (const char *p = data; p != last; ++p) {
+        if (*p == '"') {
+            // 连同这个引号一起写出，再补一个
+            m_buffer.append(segment, p - segment + 1);
+            m_buffer.append('"');
+            segment = p + 1;
+        }
+    }
+    m_buffer.append(segment, last - segment);
+    m_buffer.append('"');
+}
+
+void CsvWriter::endRow()
+{
+    m_buffer.append('\n');
+    m_rowStart = true;
+
+    if (m_buffer.size() >= m_blockSize) {
+        flush();
+    }
+}
+
+bool CsvWriter::flush()
+{
+    if (m_buffer.isEmpty()) {
+        return !m_error;
+    }
+
+    if (!m_error && m_device->write(m_buffer) != m_buffer.size()) {
+        qDebug() << "Failed to write CSV block:" << m_device->errorString();
+        m_error = true;
+    }
+    m_written += m_buffer.size();
+    // resize保留已分配的容量，下一块复用同一段内存
+    m_buffer.resize(0);
+    return !m_error;
+}
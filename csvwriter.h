@@ -0,0 +1,58 @@
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QStringEncoder>
+
+class QIODevice;
+
+//【阶段23：2024-06-24】CSV序列化：直接编码到可复用的UTF-8缓冲区，按需加引号，大块写出
+
+/**
+ * @brief CSV写入器
+ * 字段直接以UTF-8编码追加到缓冲区，不经过QTextStream逐行转码；
+ * 只有包含逗号、引号、回车或换行的字段才加引号（内部引号加倍），
+ * 缓冲区达到blockSize时一次性写入设备。检查特殊字符时一次处理16/8个字节。
+ */
+class CsvWriter
+{
+public:
+    explicit CsvWriter(QIODevice *device, qsizetype blockSize = 256 * 1024);
+    ~CsvWriter();
+
+    // UTF-8 BOM，确保Excel正确识别编码
+    void writeBom();
+
+    void writeField(const QString& value);
+    void writeField(qint64 value);
+    void writeField(int value) { writeField(qint64(value)); }
+    // 一次写入表头等整行
+    void writeRow(const QStringList& fields);
+    void endRow();
+
+    // 把缓冲区写入设备，失败返回false
+    bool flush();
+
+    qint64 bytesWritten() const { return m_written + m_buffer.size(); }
+    bool hasError() const { return m_error; }
+
+    // data中是否有需要加引号的字符
+    static bool needsQuoting(const char *data, qsizetype size);
+
+private:
+    void beginField();
+    void appendQuoted(const char *data, qsizetype size);
+
+    QIODevice *m_device;
+    qsizetype m_blockSize;
+    QByteArray m_buffer;
+    QByteArray m_scratch;       // 加引号时暂存原始字节
+    QStringEncoder m_encoder;
+    bool m_rowStart;
+    qint64 m_written;
+    bool m_error;
+};
+
+#endif // CSVWRITER_H
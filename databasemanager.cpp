@@ -1,4 +1,8 @@
 #include "databasemanager.h"
+#include "startuptrace.h"
+#include "operationtrace.h"
+#include "stringpool.h"
+#include "recurrence.h"
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QDir>
@@ -6,35 +10,50 @@
 #include <QDateTime>
 #include <QCoreApplication>
 #include <QFileInfo>
+#include <QHash>
+#include <QTimer>
+#include <QSet>
+#include <QDate>
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace {
+// 表结构版本，与PRAGMA user_version一致时跳过建表（2：周期活动系列，3：活动时间索引，4：候补转正记录，
+// 5：学期分片ID号段，6：周期活动变更日志）
+const int kSchemaVersion = 6;
+
+// 单个活动的转正记录少于此数时，改用全部活动最近30天的平均速度估计
+const int kMinPromotionSamples = 3;
+
+// SQLITE_MAX_ATTACHED的默认值
+const int kMaxAttachedTerms = 10;
+
+// 每个学期分片的ID号段大小：活动和系列ID在int范围内可容纳约200个学期
+const qint64 kTermIdBlockSize = 10000000;
+}
 
 DatabaseManager::DatabaseManager(QObject *parent)
     : QObject(parent)
     , m_initialized(false)
+    , m_shardingEnabled(false)
+    , m_recorder(nullptr)
+    , m_traceDepth(0)
+    , m_archiveTimer(nullptr)
+    , m_detailCache(2 * 1024 * 1024)
+    , m_detailCacheHits(0)
+    , m_detailCacheMisses(0)
+    , m_changeTimer(nullptr)
+    , m_dataVersion(-1)
+    , m_lastJournalSeq(0)
+    , m_archiveRetentionDays(30)
 {
-    // 初始化数据库连接
+    // 初始化数据库连接，文件路径在initialize()中设置
     m_database = QSqlDatabase::addDatabase("QSQLITE");
-    
-    // 设置数据库文件路径为当前目录
-    QString dbPath;
-    // 优先使用应用程序所在目录，如果无法获取则使用当前工作目录
-    if (QCoreApplication::instance()) {
-        dbPath = QCoreApplication::applicationDirPath() + "/campus_activity.db";
-    } else {
-        dbPath = QDir::currentPath() + "/campus_activity.db";
-    }
-    
-    // 确保目录存在
-    QFileInfo dbFileInfo(dbPath);
-    QDir dbDir = dbFileInfo.absoluteDir();
-    if (!dbDir.exists()) {
-        dbDir.mkpath(".");
-    }
-    
-    m_database.setDatabaseName(dbPath);
 }
 
 DatabaseManager::~DatabaseManager()
 {
+    stopRecording();
     if (m_database.isOpen()) {
         m_database.close();
     }
@@ -46,13 +65,26 @@ DatabaseManager& DatabaseManager::instance()
     return instance;
 }
 
-bool DatabaseManager::initialize()
+QDateTime DatabaseManager::parseTime(const QString& text)
 {
-    if (m_initialized) {
-        return true;
+    QDateTime time = QDateTime::fromString(text, "yyyy-MM-dd HH:mm:ss");
+    if (!time.isValid()) {
+        time = QDateTime::fromString(text, "yyyy-MM-dd HH:mm");
     }
+    if (!time.isValid()) {
+        time = QDateTime::fromString(text, Qt::ISODate);
+    }
+    return time;
+}
 
-    // 重新确认数据库路径（确保使用正确的目录）
+QString DatabaseManager::formatTime(const QDateTime& time)
+{
+    return time.toString("yyyy-MM-dd HH:mm:ss");
+}
+
+QString DatabaseManager::databasePath()
+{
+    // 优先使用应用程序所在目录，如果无法获取则使用当前工作目录
     QString dbPath;
     if (QCoreApplication::instance()) {
         dbPath = QCoreApplication::applicationDirPath() + "/campus_activity.db";
@@ -60,12 +92,23 @@ bool DatabaseManager::initialize()
         dbPath = QDir::currentPath() + "/campus_activity.db";
     }
 
+    // 确保目录存在
     QFileInfo dbFileInfo(dbPath);
     QDir dbDir = dbFileInfo.absoluteDir();
     if (!dbDir.exists()) {
         dbDir.mkpath(".");
     }
 
+    return dbPath;
+}
+
+bool DatabaseManager::initialize()
+{
+    if (m_initialized) {
+        return true;
+    }
+
+    const QString dbPath = m_databasePathOverride.isEmpty() ? databasePath() : m_databasePathOverride;
     m_database.setDatabaseName(dbPath);
     qDebug() << "Database path:" << dbPath;
 
@@ -74,27 +117,68 @@ bool DatabaseManager::initialize()
         qDebug() << "Failed to open database:" << m_database.lastError().text();
         return false;
     }
+    StartupTrace::mark("database opened");
+
+    if (m_shardingEnabled) {
+        if (m_activeTerm.isEmpty()) {
+            m_activeTerm = termForDate(QDate::currentDate());
+        }
+        // 当前学期分片最先附加；主库不再保存业务表，未限定库名的表名都解析到该分片
+        if (!attachTerm(m_activeTerm) || !migrateLegacyTables()) {
+            return false;
+        }
+        StartupTrace::mark("term shard attached");
+    }
 
-    // 创建表结构
-    if (!createTables()) {
-        qDebug() << "Failed to create tables:" << m_database.lastError().text();
-        return false;
+    // 表结构版本已是最新时跳过全部DDL和测试数据检查
+    if (schemaVersion("main") != kSchemaVersion) {
+        // 创建表结构（分片模式下主库只保存共享的用户表）
+        if (!createUsersTable() || (!m_shardingEnabled && !createTermTables(QString()))) {
+            qDebug() << "Failed to create tables:" << m_database.lastError().text();
+            return false;
+        }
+
+        // 初始化测试数据
+        initTestData();
+
+        setSchemaVersion("main");
+        StartupTrace::mark("schema created");
     }
 
-    // 初始化测试数据
-    initTestData();
+    initChangeTracking();
+
+    // 每天归档一次已结束的数据，保持热表较小
+    startArchiveSchedule(24 * 60);
+
+    // 多实例共用数据库文件时，通过变更日志感知其他进程的写入
+    startChangePolling(1000);
 
     m_initialized = true;
+    StartupTrace::mark("database initialized");
     qDebug() << "Database initialized successfully at:" << dbPath;
     return true;
 }
 
-bool DatabaseManager::createTables()
+QString DatabaseManager::qualifyDdl(const QString& sql, const QString& prefix)
 {
-    return createUsersTable()
-        && createActivitiesTable()
-        && createEnrollmentsTable()
-        && createWaitlistTable();
+    if (prefix.isEmpty()) {
+        return sql;
+    }
+
+    // 建表语句统一使用 IF NOT EXISTS <名称>，在名称前加上库名即可建到分片库中；
+    // SQLite外键不能跨库引用，分片中去掉指向主库users表的外键
+    static const QRegularExpression usersForeignKey(R"(,\s*FOREIGN KEY \(\w+\) REFERENCES users\(id\))");
+    return QString(sql).remove(usersForeignKey).replace("IF NOT EXISTS ", "IF NOT EXISTS " + prefix);
+}
+
+bool DatabaseManager::createTermTables(const QString& prefix)
+{
+    return createActivitiesTable(prefix)
+        && createEnrollmentsTable(prefix)
+        && createWaitlistTable(prefix)
+        && createArchiveTables(prefix)
+        && createSeriesTables(prefix)
+        && createChangeJournal(prefix);
 }
 
 bool DatabaseManager::createUsersTable()
@@ -118,7 +202,7 @@ bool DatabaseManager::createUsersTable()
     return true;
 }
 
-bool DatabaseManager::createActivitiesTable()
+bool DatabaseManager::createActivitiesTable(const QString& prefix)
 {
     QSqlQuery query(m_database);
     QString sql = R"(
@@ -142,15 +226,22 @@ bool DatabaseManager::createActivitiesTable()
         )
     )";
 
-    if (!query.exec(sql)) {
+    if (!query.exec(qualifyDdl(sql, prefix))) {
         qDebug() << "Failed to create activities table:" << query.lastError().text();
         return false;
     }
 
+    // 时间轴按时间段查询：start_time上的范围扫描，end_time条件在索引内判断，不必回表
+    const QString index = "CREATE INDEX IF NOT EXISTS idx_activities_time ON activities(start_time, end_time)";
+    if (!query.exec(qualifyDdl(index, prefix))) {
+        qDebug() << "Failed to create activities time index:" << query.lastError().text();
+        return false;
+    }
+
     return true;
 }
 
-bool DatabaseManager::createEnrollmentsTable()
+bool DatabaseManager::createEnrollmentsTable(const QString& prefix)
 {
     QSqlQuery query(m_database);
     QString sql = R"(
@@ -166,7 +257,7 @@ bool DatabaseManager::createEnrollmentsTable()
         )
     )";
 
-    if (!query.exec(sql)) {
+    if (!query.exec(qualifyDdl(sql, prefix))) {
         qDebug() << "Failed to create enrollments table:" << query.lastError().text();
         return false;
     }
@@ -174,10 +265,10 @@ bool DatabaseManager::createEnrollmentsTable()
     return true;
 }
 
-bool DatabaseManager::createWaitlistTable()
+bool DatabaseManager::createWaitlistTable(const QString& prefix)
 {
-    QSqlQuery query(m_database);
-    QString sql = R"(
+    const QStringList statements = {
+        R"(
         CREATE TABLE IF NOT EXISTS waitlist (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
             user_id INTEGER NOT NULL,
@@ -187,16 +278,267 @@ bool DatabaseManager::createWaitlistTable()
             FOREIGN KEY (activity_id) REFERENCES activities(id),
             UNIQUE(user_id, activity_id)
         )
-    )";
+        )",
+        // 按队列顺序读取某个活动的候补（队首转正、装入名次索引）
+        "CREATE INDEX IF NOT EXISTS idx_waitlist_queue ON waitlist(activity_id, added_at)",
+        // 候补转正记录，用于估计转正速度；活动归档后仍保留
+        R"(
+        CREATE TABLE IF NOT EXISTS waitlist_promotions (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            activity_id INTEGER NOT NULL,
+            user_id INTEGER NOT NULL,
+            waited_seconds INTEGER NOT NULL DEFAULT 0,
+            promoted_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+            FOREIGN KEY (user_id) REFERENCES users(id)
+        )
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_waitlist_promotions_activity ON waitlist_promotions(activity_id, promoted_at)",
+        "CREATE INDEX IF NOT EXISTS idx_waitlist_promotions_time ON waitlist_promotions(promoted_at)"
+    };
 
-    if (!query.exec(sql)) {
-        qDebug() << "Failed to create waitlist table:" << query.lastError().text();
-        return false;
+    QSqlQuery query(m_database);
+    for (const QString& sql : statements) {
+        if (!query.exec(qualifyDdl(sql, prefix))) {
+            qDebug() << "Failed to create waitlist tables:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DatabaseManager::createArchiveTables(const QString& prefix)
+{
+    // 归档表与热表结构一致，额外记录归档时间；不带UNIQUE约束，可保存多次取消记录
+    const QStringList statements = {
+        R"(
+        CREATE TABLE IF NOT EXISTS activities_archive (
+            id INTEGER PRIMARY KEY,
+            title TEXT NOT NULL,
+            description TEXT,
+            organizer_id INTEGER NOT NULL,
+            start_time TEXT NOT NULL,
+            end_time TEXT NOT NULL,
+            max_participants INTEGER NOT NULL DEFAULT 0,
+            current_participants INTEGER NOT NULL DEFAULT 0,
+            status TEXT NOT NULL,
+            category TEXT,
+            admin_id INTEGER,
+            approved_at TEXT,
+            rejected_reason TEXT,
+            created_at TEXT NOT NULL,
+            archived_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP
+        )
+        )",
+        R"(
+        CREATE TABLE IF NOT EXISTS enrollments_archive (
+            id INTEGER PRIMARY KEY,
+            user_id INTEGER NOT NULL,
+            activity_id INTEGER NOT NULL,
+            enrolled_at TEXT NOT NULL,
+            status TEXT NOT NULL,
+            archived_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP
+        )
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_enrollments_archive_activity ON enrollments_archive(activity_id)",
+        "CREATE INDEX IF NOT EXISTS idx_enrollments_archive_user ON enrollments_archive(user_id)",
+        // 跨热表和归档表的统一视图，供历史报表透明查询
+        R"(
+        CREATE VIEW IF NOT EXISTS all_activities AS
+            SELECT id, title, description, organizer_id, start_time, end_time, max_participants,
+                   current_participants, status, category, admin_id, approved_at, rejected_reason, created_at
+            FROM activities
+            UNION ALL
+            SELECT id, title, description, organizer_id, start_time, end_time, max_participants,
+                   current_participants, status, category, admin_id, approved_at, rejected_reason, created_at
+            FROM activities_archive
+        )",
+        R"(
+        CREATE VIEW IF NOT EXISTS all_enrollments AS
+            SELECT id, user_id, activity_id, enrolled_at, status FROM enrollments
+            UNION ALL
+            SELECT id, user_id, activity_id, enrolled_at, status FROM enrollments_archive
+        )"
+    };
+
+    QSqlQuery query(m_database);
+    for (const QString& sql : statements) {
+        if (!query.exec(qualifyDdl(sql, prefix))) {
+            qDebug() << "Failed to create archive tables:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DatabaseManager::createSeriesTables(const QString& prefix)
+{
+    // 系列只存一行规则；场次表是稀疏的，只有出现例外或有人报名的场次才有记录
+    const QStringList statements = {
+        R"(
+        CREATE TABLE IF NOT EXISTS activity_series (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            title TEXT NOT NULL,
+            description TEXT,
+            organizer_id INTEGER NOT NULL,
+            first_start TEXT NOT NULL,
+            first_end TEXT NOT NULL,
+            interval_days INTEGER NOT NULL CHECK(interval_days > 0),
+            occurrence_count INTEGER NOT NULL CHECK(occurrence_count > 0),
+            max_participants INTEGER NOT NULL DEFAULT 0,
+            status TEXT NOT NULL DEFAULT 'pending' CHECK(status IN ('pending', 'approved', 'rejected', 'cancelled', 'completed')),
+            category TEXT,
+            created_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+            FOREIGN KEY (organizer_id) REFERENCES users(id)
+        )
+        )",
+        R"(
+        CREATE TABLE IF NOT EXISTS series_occurrences (
+            series_id INTEGER NOT NULL,
+            occurrence_index INTEGER NOT NULL,
+            cancelled INTEGER NOT NULL DEFAULT 0,
+            start_time TEXT,
+            end_time TEXT,
+            max_participants INTEGER,
+            current_participants INTEGER NOT NULL DEFAULT 0,
+            PRIMARY KEY (series_id, occurrence_index),
+            FOREIGN KEY (series_id) REFERENCES activity_series(id)
+        )
+        )",
+        R"(
+        CREATE TABLE IF NOT EXISTS series_enrollments (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            series_id INTEGER NOT NULL,
+            occurrence_index INTEGER NOT NULL,
+            user_id INTEGER NOT NULL,
+            enrolled_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP,
+            FOREIGN KEY (series_id) REFERENCES activity_series(id),
+            FOREIGN KEY (user_id) REFERENCES users(id),
+            UNIQUE(user_id, series_id, occurrence_index)
+        )
+        )",
+        "CREATE INDEX IF NOT EXISTS idx_activity_series_start ON activity_series(first_start)"
+    };
+
+    QSqlQuery query(m_database);
+    for (const QString& sql : statements) {
+        if (!query.exec(qualifyDdl(sql, prefix))) {
+            qDebug() << "Failed to create series tables:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DatabaseManager::createChangeJournal(const QString& prefix)
+{
+    const QString journalTable = R"(
+        CREATE TABLE IF NOT EXISTS %1 (
+            seq INTEGER PRIMARY KEY AUTOINCREMENT,
+            entity TEXT NOT NULL CHECK(entity IN ('activity', 'enrollment', 'waitlist', 'series')),
+            entity_id INTEGER NOT NULL,
+            op TEXT NOT NULL CHECK(op IN ('insert', 'update', 'delete')),
+            changed_at TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP
+        )
+        )";
+
+    QSqlQuery query(m_database);
+
+    // 版本6之前的日志表的CHECK约束不允许'series'，连同序号一起复制到新表；
+    // 先删除写日志的触发器，下面按新定义重新创建
+    if (query.exec(QString("SELECT sql FROM %1sqlite_master WHERE type = 'table' AND name = 'change_journal'").arg(prefix))
+        && query.next() && !query.value(0).toString().contains("'series'")) {
+        QStringList rebuild;
+        for (const QString& trigger : { "activity_insert", "activity_update", "activity_delete",
+                                        "enrollment_insert", "enrollment_update", "enrollment_delete",
+                                        "waitlist_insert", "waitlist_delete" }) {
+            rebuild << QString("DROP TRIGGER IF EXISTS %1journal_%2").arg(prefix, trigger);
+        }
+        rebuild << qualifyDdl(journalTable.arg("change_journal_rebuild"), prefix)
+                << QString("INSERT INTO %1change_journal_rebuild SELECT * FROM %1change_journal").arg(prefix)
+                << QString("DROP TABLE %1change_journal").arg(prefix)
+                << QString("ALTER TABLE %1change_journal_rebuild RENAME TO change_journal").arg(prefix);
+
+        if (!m_database.transaction()) {
+            return false;
+        }
+        bool ok = true;
+        for (const QString& sql : rebuild) {
+            ok = ok && query.exec(sql);
+        }
+        if (!ok || !m_database.commit()) {
+            qDebug() << "Failed to rebuild change journal:" << query.lastError().text();
+            m_database.rollback();
+            return false;
+        }
+    }
+
+    // 只追加的变更日志，由触发器在与业务写入相同的事务中写入，
+    // 任何写入路径（包括批量导入和归档）都不会遗漏
+    const QStringList statements = {
+        journalTable.arg("change_journal"),
+        // 活动变更记录活动ID；报名和候补变更同样记录所属活动ID，便于按活动失效
+        R"(CREATE TRIGGER IF NOT EXISTS journal_activity_insert AFTER INSERT ON activities
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('activity', NEW.id, 'insert'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_activity_update AFTER UPDATE ON activities
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('activity', NEW.id, 'update'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_activity_delete AFTER DELETE ON activities
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('activity', OLD.id, 'delete'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_enrollment_insert AFTER INSERT ON enrollments
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('enrollment', NEW.activity_id, 'insert'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_enrollment_update AFTER UPDATE ON enrollments
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('enrollment', NEW.activity_id, 'update'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_enrollment_delete AFTER DELETE ON enrollments
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('enrollment', OLD.activity_id, 'delete'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_waitlist_insert AFTER INSERT ON waitlist
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('waitlist', NEW.activity_id, 'insert'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_waitlist_delete AFTER DELETE ON waitlist
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('waitlist', OLD.activity_id, 'delete'); END)",
+        // 周期活动的系列、场次和场次报名都记录系列ID
+        R"(CREATE TRIGGER IF NOT EXISTS journal_series_insert AFTER INSERT ON activity_series
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('series', NEW.id, 'insert'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_series_update AFTER UPDATE ON activity_series
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('series', NEW.id, 'update'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_series_delete AFTER DELETE ON activity_series
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('series', OLD.id, 'delete'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_occurrence_insert AFTER INSERT ON series_occurrences
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('series', NEW.series_id, 'insert'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_occurrence_update AFTER UPDATE ON series_occurrences
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('series', NEW.series_id, 'update'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_occurrence_delete AFTER DELETE ON series_occurrences
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('series', OLD.series_id, 'delete'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_series_enrollment_insert AFTER INSERT ON series_enrollments
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('series', NEW.series_id, 'insert'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_series_enrollment_update AFTER UPDATE ON series_enrollments
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('series', NEW.series_id, 'update'); END)",
+        R"(CREATE TRIGGER IF NOT EXISTS journal_series_enrollment_delete AFTER DELETE ON series_enrollments
+           BEGIN INSERT INTO change_journal (entity, entity_id, op) VALUES ('series', OLD.series_id, 'delete'); END)"
+    };
+
+    for (const QString& sql : statements) {
+        if (!query.exec(qualifyDdl(sql, prefix))) {
+            qDebug() << "Failed to create change journal:" << query.lastError().text();
+            return false;
+        }
     }
 
     return true;
 }
 
+void DatabaseManager::initChangeTracking()
+{
+    // 从当前位置开始跟踪，历史日志无需回放
+    QSqlQuery query(m_database);
+    if (query.exec("SELECT COALESCE(MAX(seq), 0) FROM change_journal") && query.next()) {
+        m_lastJournalSeq = query.value(0).toLongLong();
+    }
+    if (query.exec("PRAGMA " + m_termPrefix + "data_version") && query.next()) {
+        m_dataVersion = query.value(0).toLongLong();
+    }
+}
+
 void DatabaseManager::initTestData()
 {
     QSqlQuery query(m_database);
@@ -274,6 +616,10 @@ int DatabaseManager::createActivity(const QString& title, const QString& descrip
                                    const QString& organizer, const QString& startTime,
                                    const QString& endTime, int maxParticipants, const QString& category)
 {
+    traceCall(TraceOp::CreateActivity, -1, -1, { maxParticipants },
+              { title, description, organizer, startTime, endTime, category });
+    const TraceScope trace(m_traceDepth);
+
     // 获取发起人ID
     QSqlQuery query(m_database);
     query.prepare("SELECT id FROM users WHERE username = ? AND role = 'organizer'");
@@ -308,25 +654,55 @@ int DatabaseManager::createActivity(const QString& title, const QString& descrip
 
 bool DatabaseManager::updateActivityStatus(int activityId, const QString& status)
 {
+    traceCall(TraceOp::UpdateActivityStatus, -1, activityId, QList<int>(), { status });
+    const TraceScope trace(m_traceDepth);
+
     QSqlQuery query(m_database);
     query.prepare("UPDATE activities SET status = ? WHERE id = ?");
     query.addBindValue(status);
     query.addBindValue(activityId);
 
+    invalidateActivityDetail(activityId);
     return query.exec();
 }
 
-QSqlQuery DatabaseManager::getActivities(const QString& role, int userId)
+QSqlQuery DatabaseManager::getActivities(const QString& role, int userId, const QList<int>& activityIds)
+{
+    traceCall(TraceOp::GetActivities, userId, -1, activityIds, { role });
+    const TraceScope trace(m_traceDepth);
+
+    QSqlQuery query(m_database);
+    // 列表只取显示的列，描述等大字段由getActivityDetail按需查询
+    QString sql = selectSql<ActivityListRow>("WHERE 1=1");
+
+    if (role == "organizer" && userId > 0) {
+        sql += " AND a.organizer_id = " + QString::number(userId);
+    } else if (role == "student" && userId > 0) {
+        sql += " AND a.status = 'approved'";
+    }
+
+    if (!activityIds.isEmpty()) {
+        QStringList idList;
+        for (int id : activityIds) {
+            idList << QString::number(id);
+        }
+        sql += " AND a.id IN (" + idList.join(",") + ")";
+    }
+
+    sql += " ORDER BY a.created_at DESC, a.id DESC";
+
+    query.setForwardOnly(true);
+    query.exec(sql);
+    return query;
+}
+
+QSqlQuery DatabaseManager::getActivityPage(const QString& role, int userId, int afterId, int limit)
 {
+    traceCall(TraceOp::GetActivityPage, userId, afterId, { limit }, { role });
+    const TraceScope trace(m_traceDepth);
+
     QSqlQuery query(m_database);
-    QString sql = R"(
-        SELECT a.id, a.title, a.description, u.username as organizer_name,
-               a.start_time, a.end_time, a.max_participants, a.current_participants,
-               a.status, a.category, a.created_at
-        FROM activities a
-        JOIN users u ON a.organizer_id = u.id
-        WHERE 1=1
-    )";
+    QString sql = selectSql<ActivityListRow>("WHERE 1=1");
 
     if (role == "organizer" && userId > 0) {
         sql += " AND a.organizer_id = " + QString::number(userId);
@@ -334,30 +710,216 @@ QSqlQuery DatabaseManager::getActivities(const QString& role, int userId)
         sql += " AND a.status = 'approved'";
     }
 
-    sql += " ORDER BY a.created_at DESC";
+    // 按 (created_at, id) 从上一页最后一行之后继续，与getActivities的排序一致
+    if (afterId > 0) {
+        const QString after = QString::number(afterId);
+        sql += " AND (a.created_at < (SELECT created_at FROM activities WHERE id = " + after + ")"
+               " OR (a.created_at = (SELECT created_at FROM activities WHERE id = " + after + ")"
+               " AND a.id < " + after + "))";
+    }
+
+    sql += " ORDER BY a.created_at DESC, a.id DESC LIMIT " + QString::number(limit);
 
+    query.setForwardOnly(true);
     query.exec(sql);
     return query;
 }
 
 QSqlQuery DatabaseManager::getActivityById(int activityId)
 {
+    traceCall(TraceOp::GetActivityById, -1, activityId);
+    const TraceScope trace(m_traceDepth);
+
     QSqlQuery query(m_database);
-    query.prepare(R"(
-        SELECT a.id, a.title, a.description, u.username as organizer_name,
-               a.start_time, a.end_time, a.max_participants, a.current_participants,
-               a.status, a.category, a.created_at
-        FROM activities a
-        JOIN users u ON a.organizer_id = u.id
-        WHERE a.id = ?
-    )");
+    query.prepare(selectSql<ActivityRow>("WHERE a.id = ?"));
     query.addBindValue(activityId);
     query.exec();
     return query;
 }
 
+bool DatabaseManager::getActivityDetail(int activityId, ActivityDetail& detail)
+{
+    traceCall(TraceOp::GetActivityDetail, -1, activityId);
+    const TraceScope trace(m_traceDepth);
+
+    if (const ActivityDetail *cached = m_detailCache.object(activityId)) {
+        ++m_detailCacheHits;
+        detail = *cached;
+        return true;
+    }
+
+    ++m_detailCacheMisses;
+    QSqlQuery query = getActivityById(activityId);
+    if (!query.next()) {
+        return false;
+    }
+
+    auto *record = new ActivityDetail;
+    readRow(query, *record);
+    record->organizerName = StringPool::intern(record->organizerName);
+    record->status = StringPool::intern(record->status);
+    record->category = StringPool::intern(record->category);
+
+    // 成本按字符串实际占用估算（驻留的字段由所有记录共享，不计入），缓存总量受字节上限约束
+    qsizetype cost = sizeof(ActivityDetail);
+    for (const QString *text : { &record->title, &record->description, &record->startTime,
+                                 &record->endTime, &record->createdAt }) {
+        cost += text->capacity() * sizeof(QChar);
+    }
+
+    detail = *record;
+    m_detailCache.insert(activityId, record, cost);
+    return true;
+}
+
+void DatabaseManager::invalidateActivityDetail(int activityId)
+{
+    m_detailCache.remove(activityId);
+}
+
+void DatabaseManager::setDetailCacheLimit(qint64 bytes)
+{
+    m_detailCache.setMaxCost(bytes);
+}
+
+DetailCacheStats DatabaseManager::detailCacheStats() const
+{
+    DetailCacheStats stats;
+    stats.hits = m_detailCacheHits;
+    stats.misses = m_detailCacheMisses;
+    stats.entries = m_detailCache.count();
+    stats.bytes = m_detailCache.totalCost();
+    const qint64 lookups = stats.hits + stats.misses;
+    stats.hitRate = lookups > 0 ? double(stats.hits) / lookups : 0.0;
+    return stats;
+}
+
+std::vector<TimelineRow> DatabaseManager::getActivitiesInRange(const QString& from, const QString& to,
+                                                              const QString& role, int userId)
+{
+    traceCall(TraceOp::GetActivitiesInRange, userId, -1, QList<int>(), { from, to, role });
+    const TraceScope trace(m_traceDepth);
+
+    // 与 [from, to) 有交集：start_time < to 走索引范围，end_time > from 在索引项上过滤
+    QString tail = "WHERE a.start_time < ? AND a.end_time > ?";
+    if (role == "organizer" && userId > 0) {
+        tail += " AND a.organizer_id = " + QString::number(userId);
+    } else if (role == "student" && userId > 0) {
+        tail += " AND a.status = 'approved'";
+    }
+    tail += " ORDER BY a.start_time";
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(selectSql<TimelineRow>(tail));
+    const QDateTime windowFrom = parseTime(from);
+    const QDateTime windowTo = parseTime(to);
+    query.addBindValue(windowTo.isValid() ? formatTime(windowTo) : to);
+    query.addBindValue(windowFrom.isValid() ? formatTime(windowFrom) : from);
+    if (!query.exec()) {
+        qDebug() << "Activity range query failed:" << query.lastError().text();
+        return std::vector<TimelineRow>();
+    }
+    return fetchRows<TimelineRow>(query);
+}
+
+bool DatabaseManager::getActivityTimeBounds(QString& earliest, QString& latest)
+{
+    // 分成两个子查询，MIN和MAX才会各自只取索引一端的一项（写在同一个SELECT里会扫描整个索引）
+    QSqlQuery query(m_database);
+    if (!query.exec("SELECT (SELECT MIN(start_time) FROM activities), (SELECT MAX(start_time) FROM activities)")
+        || !query.next()
+        || query.value(0).isNull()) {
+        return false;
+    }
+    earliest = query.value(0).toString();
+    latest = query.value(1).toString();
+    return true;
+}
+
+QVector<StudentActivityRow> DatabaseManager::getStudentActivityListing(int userId)
+{
+    traceCall(TraceOp::GetStudentListing, userId, -1);
+    const TraceScope trace(m_traceDepth);
+
+    QVector<StudentActivityRow> rows;
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(selectSql<StudentListingRow>("WHERE a.status = 'approved' ORDER BY a.start_time ASC"));
+    query.addBindValue(userId);
+    query.addBindValue(userId);
+
+    if (!query.exec()) {
+        qDebug() << "Student listing query failed:" << query.lastError().text();
+        return rows;
+    }
+
+    // 本人已报名活动的下标，天然按开始时间有序
+    QVector<int> schedule;
+    StudentListingRow listing;
+    while (query.next()) {
+        readRow(query, listing);
+
+        StudentActivityRow row;
+        row.id = listing.id;
+        row.title = listing.title;
+        row.organizerName = listing.organizerName;
+        row.startTime = listing.startTime;
+        row.endTime = listing.endTime;
+        row.maxParticipants = listing.maxParticipants;
+        row.currentParticipants = listing.currentParticipants;
+        row.status = listing.status;
+        row.category = listing.category;
+
+        if (listing.enrolled) {
+            row.availability = Availability::Enrolled;
+            schedule.append(rows.size());
+        } else if (listing.waitlisted) {
+            row.availability = Availability::Waitlisted;
+        } else if (row.currentParticipants >= row.maxParticipants) {
+            row.availability = Availability::Full;
+        }
+        rows.append(row);
+    }
+
+    if (schedule.isEmpty()) {
+        return rows;
+    }
+
+    // 扫描线：活动按开始时间递增处理，指针j划过所有开始不晚于当前活动的日程并记录最大结束时间。
+    // 与[start, end)冲突的日程要么已被划过且结束晚于start，要么是下一个尚未划过且开始早于end的日程。
+    // 时间字符串格式统一，字符串比较即时间比较，与checkTimeConflict保持一致。
+    int j = 0;
+    QString maxEnd;
+    for (StudentActivityRow& row : rows) {
+        if (row.availability == Availability::Enrolled || row.availability == Availability::Waitlisted) {
+            continue;
+        }
+
+        while (j < schedule.size() && rows.at(schedule.at(j)).startTime <= row.startTime) {
+            const QString& end = rows.at(schedule.at(j)).endTime;
+            if (end > maxEnd) {
+                maxEnd = end;
+            }
+            ++j;
+        }
+
+        const bool overlapsEarlier = maxEnd > row.startTime;
+        const bool overlapsNext = j < schedule.size() && rows.at(schedule.at(j)).startTime < row.endTime;
+        if (overlapsEarlier || overlapsNext) {
+            row.availability = Availability::Conflict;
+        }
+    }
+
+    return rows;
+}
+
 bool DatabaseManager::checkTimeConflict(int userId, const QString& startTime, const QString& endTime, int excludeActivityId)
 {
+    traceCall(TraceOp::CheckTimeConflict, userId, excludeActivityId, QList<int>(), { startTime, endTime });
+    const TraceScope trace(m_traceDepth);
+
     QSqlQuery query(m_database);
     QString sql = R"(
         SELECT a.id, a.title, a.start_time, a.end_time
@@ -387,27 +949,52 @@ bool DatabaseManager::checkTimeConflict(int userId, const QString& startTime, co
         return false;
     }
 
-    return query.next(); // 有冲突返回true
+    if (query.next()) {
+        return true; // 有冲突返回true
+    }
+
+    // 周期活动的已报名场次不物化为活动行，场次时间由规则直接算出（改期的场次取例外中的时间）。
+    // datetime()和改期时间都是 yyyy-MM-dd HH:mm:ss，调用方传入的时间先统一成同一格式再按字符串比较，
+    // 否则 "HH:mm" 形式的边界会因长度不同而误判
+    const QDateTime start = parseTime(startTime);
+    const QDateTime end = parseTime(endTime);
+    query.prepare(R"(
+        SELECT 1
+        FROM series_enrollments e
+        JOIN activity_series s ON e.series_id = s.id
+        LEFT JOIN series_occurrences o ON o.series_id = e.series_id AND o.occurrence_index = e.occurrence_index
+        WHERE e.user_id = ? AND s.status = 'approved' AND COALESCE(o.cancelled, 0) = 0
+          AND COALESCE(o.start_time, datetime(s.first_start, '+' || (e.occurrence_index * s.interval_days) || ' days')) < ?
+          AND COALESCE(o.end_time, datetime(s.first_end, '+' || (e.occurrence_index * s.interval_days) || ' days')) > ?
+        LIMIT 1
+    )");
+    query.addBindValue(userId);
+    query.addBindValue(end.isValid() ? formatTime(end) : endTime);
+    query.addBindValue(start.isValid() ? formatTime(start) : startTime);
+
+    return query.exec() && query.next();
 }
 
 bool DatabaseManager::enrollActivity(int userId, int activityId, bool& hasConflict, QString& conflictInfo)
 {
+    traceCall(TraceOp::Enroll, userId, activityId);
+    const TraceScope trace(m_traceDepth);
+
     // 检查活动状态
     QSqlQuery checkQuery(m_database);
-    checkQuery.prepare("SELECT status, max_participants, current_participants, start_time, end_time FROM activities WHERE id = ?");
+    checkQuery.prepare(selectSql<ActivityCapacityRow>("WHERE id = ?"));
     checkQuery.addBindValue(activityId);
 
     if (!checkQuery.exec() || !checkQuery.next()) {
         return false;
     }
 
-    QString status = checkQuery.value(0).toString();
-    int maxParticipants = checkQuery.value(1).toInt();
-    int currentParticipants = checkQuery.value(2).toInt();
-    QString startTime = checkQuery.value(3).toString();
-    QString endTime = checkQuery.value(4).toString();
+    ActivityCapacityRow activity;
+    readRow(checkQuery, activity);
+    const QString& startTime = activity.startTime;
+    const QString& endTime = activity.endTime;
 
-    if (status != "approved") {
+    if (activity.status != "approved") {
         return false;
     }
 
@@ -429,7 +1016,7 @@ bool DatabaseManager::enrollActivity(int userId, int activityId, bool& hasConfli
     }
 
     // 检查是否已满
-    if (currentParticipants >= maxParticipants) {
+    if (activity.currentParticipants >= activity.maxParticipants) {
         // 加入候补队列
         addToWaitlist(userId, activityId);
         hasConflict = false;
@@ -451,6 +1038,7 @@ bool DatabaseManager::enrollActivity(int userId, int activityId, bool& hasConfli
     query.prepare("UPDATE activities SET current_participants = current_participants + 1 WHERE id = ?");
     query.addBindValue(activityId);
     query.exec();
+    invalidateActivityDetail(activityId);
 
     hasConflict = false;
     conflictInfo = "报名成功";
@@ -459,12 +1047,37 @@ bool DatabaseManager::enrollActivity(int userId, int activityId, bool& hasConfli
 
 bool DatabaseManager::cancelEnrollment(int userId, int activityId)
 {
+    traceCall(TraceOp::Cancel, userId, activityId);
+    const TraceScope trace(m_traceDepth);
+
+    if (!m_database.transaction()) {
+        qDebug() << "Failed to begin cancel transaction:" << m_database.lastError().text();
+        return false;
+    }
+
+    // 取消的报名直接移入归档表，热表中只保留有效报名，
+    // 避免同一学生多次取消时触发UNIQUE(user_id, activity_id, status)约束
     QSqlQuery query(m_database);
-    query.prepare("UPDATE enrollments SET status = 'cancelled' WHERE user_id = ? AND activity_id = ? AND status = 'enrolled'");
+    query.prepare(R"(
+        INSERT INTO enrollments_archive (id, user_id, activity_id, enrolled_at, status)
+        SELECT id, user_id, activity_id, enrolled_at, 'cancelled'
+        FROM enrollments
+        WHERE user_id = ? AND activity_id = ? AND status = 'enrolled'
+    )");
     query.addBindValue(userId);
     query.addBindValue(activityId);
 
     if (!query.exec() || query.numRowsAffected() == 0) {
+        m_database.rollback();
+        return false;
+    }
+
+    query.prepare("DELETE FROM enrollments WHERE user_id = ? AND activity_id = ? AND status = 'enrolled'");
+    query.addBindValue(userId);
+    query.addBindValue(activityId);
+    if (!query.exec()) {
+        qDebug() << "Failed to remove cancelled enrollment:" << query.lastError().text();
+        m_database.rollback();
         return false;
     }
 
@@ -472,32 +1085,407 @@ bool DatabaseManager::cancelEnrollment(int userId, int activityId)
     query.prepare("UPDATE activities SET current_participants = current_participants - 1 WHERE id = ?");
     query.addBindValue(activityId);
     query.exec();
+    invalidateActivityDetail(activityId);
 
     // 处理候补队列
     processWaitlist(activityId);
 
+    if (!m_database.commit()) {
+        qDebug() << "Failed to commit cancellation:" << m_database.lastError().text();
+        m_database.rollback();
+        // 转正时已从名次索引中移除的用户随回滚回到队列，索引下次查询时重新装入
+        m_waitlistIndex.invalidate(activityId);
+        return false;
+    }
+
     return true;
 }
 
-QSqlQuery DatabaseManager::getEnrollments(int activityId, int userId)
+int DatabaseManager::createActivitySeries(const QString& title, const QString& description,
+                                          const QString& organizer, const QString& firstStart,
+                                          const QString& firstEnd, int intervalDays, int occurrenceCount,
+                                          int maxParticipants, const QString& category)
 {
-    QSqlQuery query(m_database);
-    QString sql = R"(
-        SELECT e.id, e.user_id, u.username, e.enrolled_at, e.status, a.title as activity_title
-        FROM enrollments e
-        JOIN users u ON e.user_id = u.id
-        JOIN activities a ON e.activity_id = a.id
-        WHERE e.status = 'enrolled'
-    )";
-
-    if (activityId > 0) {
-        sql += " AND e.activity_id = " + QString::number(activityId);
-    }
-    if (userId > 0) {
-        sql += " AND e.user_id = " + QString::number(userId);
+    traceCall(TraceOp::CreateSeries, -1, -1, { intervalDays, occurrenceCount, maxParticipants },
+              { title, description, organizer, firstStart, firstEnd, category });
+    const TraceScope trace(m_traceDepth);
+
+    RecurrenceRule rule;
+    rule.firstStart = parseTime(firstStart);
+    rule.firstEnd = parseTime(firstEnd);
+    rule.intervalDays = intervalDays;
+    rule.occurrenceCount = occurrenceCount;
+    if (!rule.isValid()) {
+        qDebug() << "Invalid recurrence rule for series" << title;
+        return -1;
     }
 
-    sql += " ORDER BY e.enrolled_at ASC";
+    QSqlQuery query(m_database);
+    query.prepare("SELECT id FROM users WHERE username = ? AND role = 'organizer'");
+    query.addBindValue(organizer);
+    if (!query.exec() || !query.next()) {
+        return -1;
+    }
+    const int organizerId = query.value(0).toInt();
+
+    query.prepare(R"(
+        INSERT INTO activity_series (title, description, organizer_id, first_start, first_end,
+                                     interval_days, occurrence_count, max_participants, category, status)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, 'pending')
+    )");
+    query.addBindValue(title);
+    query.addBindValue(description);
+    query.addBindValue(organizerId);
+    query.addBindValue(formatTime(rule.firstStart));
+    query.addBindValue(formatTime(rule.firstEnd));
+    query.addBindValue(intervalDays);
+    query.addBindValue(occurrenceCount);
+    query.addBindValue(maxParticipants);
+    query.addBindValue(category);
+
+    if (!query.exec()) {
+        qDebug() << "Failed to create activity series:" << query.lastError().text();
+        return -1;
+    }
+
+    return query.lastInsertId().toInt();
+}
+
+bool DatabaseManager::updateSeriesStatus(int seriesId, const QString& status)
+{
+    traceCall(TraceOp::UpdateSeriesStatus, -1, seriesId, QList<int>(), { status });
+    const TraceScope trace(m_traceDepth);
+
+    QSqlQuery query(m_database);
+    query.prepare("UPDATE activity_series SET status = ? WHERE id = ?");
+    query.addBindValue(status);
+    query.addBindValue(seriesId);
+    return query.exec() && query.numRowsAffected() > 0;
+}
+
+bool DatabaseManager::updateOccurrence(int seriesId, int occurrenceIndex, const QString& assignments,
+                                       const QVariantList& values)
+{
+    // 场次记录按需创建，已存在时只更新给定的列
+    QSqlQuery query(m_database);
+    query.prepare(R"(
+        INSERT INTO series_occurrences (series_id, occurrence_index) VALUES (?, ?)
+        ON CONFLICT(series_id, occurrence_index) DO NOTHING
+    )");
+    query.addBindValue(seriesId);
+    query.addBindValue(occurrenceIndex);
+    if (!query.exec()) {
+        qDebug() << "Failed to create occurrence:" << query.lastError().text();
+        return false;
+    }
+
+    query.prepare(QString("UPDATE series_occurrences SET %1 WHERE series_id = ? AND occurrence_index = ?").arg(assignments));
+    for (const QVariant& value : values) {
+        query.addBindValue(value);
+    }
+    query.addBindValue(seriesId);
+    query.addBindValue(occurrenceIndex);
+    return query.exec();
+}
+
+bool DatabaseManager::cancelOccurrence(int seriesId, int occurrenceIndex)
+{
+    traceCall(TraceOp::CancelSeriesOccurrence, -1, seriesId, { occurrenceIndex });
+    const TraceScope trace(m_traceDepth);
+
+    return updateOccurrence(seriesId, occurrenceIndex, "cancelled = 1", QVariantList());
+}
+
+bool DatabaseManager::rescheduleOccurrence(int seriesId, int occurrenceIndex,
+                                           const QString& startTime, const QString& endTime)
+{
+    traceCall(TraceOp::RescheduleOccurrence, -1, seriesId, { occurrenceIndex }, { startTime, endTime });
+    const TraceScope trace(m_traceDepth);
+
+    const QDateTime start = parseTime(startTime);
+    const QDateTime end = parseTime(endTime);
+    if (!start.isValid() || !end.isValid() || end <= start) {
+        return false;
+    }
+    return updateOccurrence(seriesId, occurrenceIndex, "start_time = ?, end_time = ?",
+                            { formatTime(start), formatTime(end) });
+}
+
+bool DatabaseManager::setOccurrenceCapacity(int seriesId, int occurrenceIndex, int maxParticipants)
+{
+    traceCall(TraceOp::SetOccurrenceCapacity, -1, seriesId, { occurrenceIndex, maxParticipants });
+    const TraceScope trace(m_traceDepth);
+
+    return updateOccurrence(seriesId, occurrenceIndex, "max_participants = ?", { maxParticipants });
+}
+
+QVector<ActivityOccurrence> DatabaseManager::getOccurrences(const QString& from, const QString& to,
+                                                           const QString& role, int userId)
+{
+    traceCall(TraceOp::GetOccurrences, userId, -1, QList<int>(), { from, to, role });
+    const TraceScope trace(m_traceDepth);
+
+    QVector<ActivityOccurrence> occurrences;
+    const QDateTime windowFrom = parseTime(from);
+    const QDateTime windowTo = parseTime(to);
+    if (!windowFrom.isValid() || !windowTo.isValid()) {
+        return occurrences;
+    }
+
+    // 只取规则覆盖范围（或改期后的场次）与窗口有交集的系列
+    QString tail = R"(
+        WHERE ((s.first_start < ?
+                AND datetime(s.first_end, '+' || ((s.occurrence_count - 1) * s.interval_days) || ' days') > ?)
+               OR EXISTS (SELECT 1 FROM series_occurrences o
+                          WHERE o.series_id = s.id AND o.start_time < ? AND o.end_time > ?))
+    )";
+    if (role == "organizer" && userId > 0) {
+        tail += " AND s.organizer_id = " + QString::number(userId);
+    } else if (role == "student" && userId > 0) {
+        tail += " AND s.status = 'approved'";
+    }
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(selectSql<ActivitySeriesRow>(tail));
+    // 与库中 yyyy-MM-dd HH:mm:ss 的文本比较，绑定规范化后的时间（调用方可能传入ISO格式或不带秒）
+    const QString fromText = formatTime(windowFrom);
+    const QString toText = formatTime(windowTo);
+    query.addBindValue(toText);
+    query.addBindValue(fromText);
+    query.addBindValue(toText);
+    query.addBindValue(fromText);
+    if (!query.exec()) {
+        qDebug() << "Series query failed:" << query.lastError().text();
+        return occurrences;
+    }
+    const std::vector<ActivitySeriesRow> seriesRows = fetchRows<ActivitySeriesRow>(query);
+    if (seriesRows.empty()) {
+        return occurrences;
+    }
+
+    // 这些系列的稀疏场次记录（例外、单场容量和报名人数）
+    QHash<QPair<int, int>, SeriesOccurrenceRow> states;
+    QStringList idList;
+    for (const ActivitySeriesRow& series : seriesRows) {
+        idList << QString::number(series.id);
+    }
+    query.prepare(selectSql<SeriesOccurrenceRow>("WHERE o.series_id IN (" + idList.join(",") + ")"));
+    if (query.exec()) {
+        for (const SeriesOccurrenceRow& state : fetchRows<SeriesOccurrenceRow>(query)) {
+            states.insert({ state.seriesId, state.occurrenceIndex }, state);
+        }
+    }
+
+    auto append = [&occurrences](const ActivitySeriesRow& series, int index, const QString& start,
+                                 const QString& end, const SeriesOccurrenceRow& state, bool rescheduled) {
+        ActivityOccurrence occurrence;
+        occurrence.seriesId = series.id;
+        occurrence.occurrenceIndex = index;
+        occurrence.title = series.title;
+        occurrence.organizerName = series.organizerName;
+        occurrence.startTime = start;
+        occurrence.endTime = end;
+        occurrence.maxParticipants = state.maxParticipants >= 0 ? state.maxParticipants : series.maxParticipants;
+        occurrence.currentParticipants = state.currentParticipants;
+        occurrence.status = series.status;
+        occurrence.category = series.category;
+        occurrence.rescheduled = rescheduled;
+        occurrences.append(occurrence);
+    };
+
+    for (const ActivitySeriesRow& series : seriesRows) {
+        RecurrenceRule rule;
+        rule.firstStart = parseTime(series.firstStart);
+        rule.firstEnd = parseTime(series.firstEnd);
+        rule.intervalDays = series.intervalDays;
+        rule.occurrenceCount = series.occurrenceCount;
+
+        // 只展开窗口内的场次，取消或改期的由场次记录决定
+        int first = 0;
+        int last = -1;
+        if (rule.indexRange(windowFrom, windowTo, first, last)) {
+            for (int index = first; index <= last; ++index) {
+                const SeriesOccurrenceRow state = states.value({ series.id, index });
+                if (state.cancelled || !state.startTime.isEmpty()) {
+                    continue;
+                }
+                append(series, index, formatTime(rule.occurrenceStart(index)),
+                       formatTime(rule.occurrenceEnd(index)), state, false);
+            }
+        }
+    }
+
+    // 改期的场次可能落在规则范围之外，单独按改期后的时间判断
+    QHash<int, const ActivitySeriesRow *> seriesById;
+    for (const ActivitySeriesRow& series : seriesRows) {
+        seriesById.insert(series.id, &series);
+    }
+    for (auto it = states.constBegin(); it != states.constEnd(); ++it) {
+        const SeriesOccurrenceRow& state = it.value();
+        if (state.cancelled || state.startTime.isEmpty() || !(state.startTime < toText && state.endTime > fromText)) {
+            continue;
+        }
+        append(*seriesById.value(it.key().first), it.key().second, state.startTime, state.endTime, state, true);
+    }
+
+    std::sort(occurrences.begin(), occurrences.end(), [](const ActivityOccurrence& a, const ActivityOccurrence& b) {
+        return a.startTime < b.startTime;
+    });
+    return occurrences;
+}
+
+bool DatabaseManager::enrollOccurrence(int userId, int seriesId, int occurrenceIndex,
+                                       bool& hasConflict, QString& conflictInfo)
+{
+    traceCall(TraceOp::EnrollOccurrence, userId, seriesId, { occurrenceIndex });
+    const TraceScope trace(m_traceDepth);
+
+    hasConflict = false;
+
+    QSqlQuery query(m_database);
+    query.prepare(selectSql<ActivitySeriesRow>("WHERE s.id = ?"));
+    query.addBindValue(seriesId);
+    if (!query.exec() || !query.next()) {
+        return false;
+    }
+    ActivitySeriesRow series;
+    readRow(query, series);
+
+    if (series.status != "approved" || occurrenceIndex < 0 || occurrenceIndex >= series.occurrenceCount) {
+        return false;
+    }
+
+    RecurrenceRule rule;
+    rule.firstStart = parseTime(series.firstStart);
+    rule.firstEnd = parseTime(series.firstEnd);
+    rule.intervalDays = series.intervalDays;
+    QString startTime = formatTime(rule.occurrenceStart(occurrenceIndex));
+    QString endTime = formatTime(rule.occurrenceEnd(occurrenceIndex));
+    int maxParticipants = series.maxParticipants;
+    int currentParticipants = 0;
+
+    query.prepare(selectSql<SeriesOccurrenceRow>("WHERE o.series_id = ? AND o.occurrence_index = ?"));
+    query.addBindValue(seriesId);
+    query.addBindValue(occurrenceIndex);
+    if (query.exec() && query.next()) {
+        SeriesOccurrenceRow state;
+        readRow(query, state);
+        if (state.cancelled) {
+            conflictInfo = "该场次已取消";
+            return false;
+        }
+        if (!state.startTime.isEmpty()) {
+            startTime = state.startTime;
+            endTime = state.endTime;
+        }
+        if (state.maxParticipants >= 0) {
+            maxParticipants = state.maxParticipants;
+        }
+        currentParticipants = state.currentParticipants;
+    }
+
+    // 检查是否已报名
+    query.prepare("SELECT id FROM series_enrollments WHERE user_id = ? AND series_id = ? AND occurrence_index = ?");
+    query.addBindValue(userId);
+    query.addBindValue(seriesId);
+    query.addBindValue(occurrenceIndex);
+    if (query.exec() && query.next()) {
+        conflictInfo = "您已经报名了该场次";
+        return false;
+    }
+
+    // 检查时间冲突（普通活动和其他系列的已报名场次）
+    hasConflict = checkTimeConflict(userId, startTime, endTime);
+    if (hasConflict) {
+        conflictInfo = "您已报名了时间冲突的其他活动";
+        return false;
+    }
+
+    if (currentParticipants >= maxParticipants) {
+        conflictInfo = "该场次已满";
+        return false;
+    }
+
+    if (!m_database.transaction()) {
+        return false;
+    }
+
+    query.prepare("INSERT INTO series_enrollments (series_id, occurrence_index, user_id) VALUES (?, ?, ?)");
+    query.addBindValue(seriesId);
+    query.addBindValue(occurrenceIndex);
+    query.addBindValue(userId);
+    bool ok = query.exec();
+
+    if (ok) {
+        query.prepare(R"(
+            INSERT INTO series_occurrences (series_id, occurrence_index, current_participants) VALUES (?, ?, 1)
+            ON CONFLICT(series_id, occurrence_index) DO UPDATE SET current_participants = current_participants + 1
+        )");
+        query.addBindValue(seriesId);
+        query.addBindValue(occurrenceIndex);
+        ok = query.exec();
+    }
+
+    if (!ok || !m_database.commit()) {
+        qDebug() << "Failed to enroll occurrence:" << query.lastError().text();
+        m_database.rollback();
+        return false;
+    }
+
+    conflictInfo = "报名成功";
+    return true;
+}
+
+bool DatabaseManager::cancelOccurrenceEnrollment(int userId, int seriesId, int occurrenceIndex)
+{
+    traceCall(TraceOp::CancelOccurrence, userId, seriesId, { occurrenceIndex });
+    const TraceScope trace(m_traceDepth);
+
+    if (!m_database.transaction()) {
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    query.prepare("DELETE FROM series_enrollments WHERE user_id = ? AND series_id = ? AND occurrence_index = ?");
+    query.addBindValue(userId);
+    query.addBindValue(seriesId);
+    query.addBindValue(occurrenceIndex);
+    if (!query.exec() || query.numRowsAffected() == 0) {
+        m_database.rollback();
+        return false;
+    }
+
+    query.prepare(R"(
+        UPDATE series_occurrences SET current_participants = current_participants - 1
+        WHERE series_id = ? AND occurrence_index = ?
+    )");
+    query.addBindValue(seriesId);
+    query.addBindValue(occurrenceIndex);
+    if (!query.exec() || !m_database.commit()) {
+        qDebug() << "Failed to cancel occurrence enrollment:" << query.lastError().text();
+        m_database.rollback();
+        return false;
+    }
+    return true;
+}
+
+QSqlQuery DatabaseManager::getEnrollments(int activityId, int userId)
+{
+    traceCall(TraceOp::GetEnrollments, userId, activityId);
+    const TraceScope trace(m_traceDepth);
+
+    QSqlQuery query(m_database);
+    QString sql = selectSql<EnrollmentListRow>("WHERE e.status = 'enrolled'");
+
+    if (activityId > 0) {
+        sql += " AND e.activity_id = " + QString::number(activityId);
+    }
+    if (userId > 0) {
+        sql += " AND e.user_id = " + QString::number(userId);
+    }
+
+    sql += " ORDER BY e.enrolled_at ASC";
 
     query.exec(sql);
     return query;
@@ -505,73 +1493,82 @@ QSqlQuery DatabaseManager::getEnrollments(int activityId, int userId)
 
 bool DatabaseManager::addToWaitlist(int userId, int activityId)
 {
+    traceCall(TraceOp::AddToWaitlist, userId, activityId);
+    const TraceScope trace(m_traceDepth);
+
     QSqlQuery query(m_database);
     query.prepare("INSERT OR IGNORE INTO waitlist (user_id, activity_id) VALUES (?, ?)");
     query.addBindValue(userId);
     query.addBindValue(activityId);
 
-    return query.exec();
+    if (!query.exec()) {
+        return false;
+    }
+    // 新加入的总在队尾
+    if (query.numRowsAffected() > 0) {
+        m_waitlistIndex.append(activityId, userId);
+    }
+    return true;
 }
 
 bool DatabaseManager::processWaitlist(int activityId)
 {
-    // 检查活动是否还有空位
+    traceCall(TraceOp::ProcessWaitlist, -1, activityId);
+    const TraceScope trace(m_traceDepth);
+
+    // 检查活动是否还有空位（同时取回时间，后面的冲突检查无需再查一次）
     QSqlQuery checkQuery(m_database);
-    checkQuery.prepare("SELECT max_participants, current_participants FROM activities WHERE id = ?");
+    checkQuery.prepare(selectSql<ActivityCapacityRow>("WHERE id = ?"));
     checkQuery.addBindValue(activityId);
 
     if (!checkQuery.exec() || !checkQuery.next()) {
         return false;
     }
 
-    int maxParticipants = checkQuery.value(0).toInt();
-    int currentParticipants = checkQuery.value(1).toInt();
+    ActivityCapacityRow activity;
+    readRow(checkQuery, activity);
 
-    if (currentParticipants >= maxParticipants) {
+    if (activity.currentParticipants >= activity.maxParticipants) {
         return false; // 仍然满员
     }
 
-    // 获取候补队列中的第一个用户
+    // 获取候补队列中的第一个用户（加入时间相同时按加入顺序，与名次索引一致）
     QSqlQuery waitlistQuery(m_database);
-    waitlistQuery.prepare(R"(
-        SELECT user_id FROM waitlist
-        WHERE activity_id = ?
-        ORDER BY added_at ASC
-        LIMIT 1
-    )");
+    waitlistQuery.prepare(selectSql<WaitlistQueueRow>("WHERE activity_id = ? ORDER BY added_at ASC, id ASC LIMIT 1"));
     waitlistQuery.addBindValue(activityId);
 
     if (!waitlistQuery.exec() || !waitlistQuery.next()) {
         return false; // 候补队列为空
     }
 
-    int userId = waitlistQuery.value(0).toInt();
-
-    // 检查时间冲突
-    QSqlQuery activityQuery(m_database);
-    activityQuery.prepare("SELECT start_time, end_time FROM activities WHERE id = ?");
-    activityQuery.addBindValue(activityId);
-    activityQuery.exec();
-    activityQuery.next();
-    QString startTime = activityQuery.value(0).toString();
-    QString endTime = activityQuery.value(1).toString();
+    WaitlistQueueRow head;
+    readRow(waitlistQuery, head);
+    const int userId = head.userId;
 
-    if (checkTimeConflict(userId, startTime, endTime, activityId)) {
-        // 有时间冲突，跳过这个用户
-        QSqlQuery deleteWaitlist(m_database);
-        deleteWaitlist.prepare("DELETE FROM waitlist WHERE user_id = ? AND activity_id = ?");
-        deleteWaitlist.addBindValue(userId);
-        deleteWaitlist.addBindValue(activityId);
-        deleteWaitlist.exec();
-        return false;
-    }
-
-    // 从候补队列移除
+    // 从候补队列移除：有时间冲突的跳过这个用户，否则转正。
+    // 名次索引只在删除成功后更新；调用方的事务回滚时由调用方作废该活动的索引
     QSqlQuery deleteWaitlist(m_database);
     deleteWaitlist.prepare("DELETE FROM waitlist WHERE user_id = ? AND activity_id = ?");
     deleteWaitlist.addBindValue(userId);
     deleteWaitlist.addBindValue(activityId);
-    deleteWaitlist.exec();
+    if (!deleteWaitlist.exec() || deleteWaitlist.numRowsAffected() == 0) {
+        qDebug() << "Failed to remove waitlist head:" << deleteWaitlist.lastError().text();
+        m_waitlistIndex.invalidate(activityId);
+        return false;
+    }
+    m_waitlistIndex.remove(activityId, userId);
+
+    if (checkTimeConflict(userId, activity.startTime, activity.endTime, activityId)) {
+        return false;
+    }
+
+    // 记录转正，供估计后面的人的等待时间
+    QSqlQuery promotionQuery(m_database);
+    promotionQuery.prepare("INSERT INTO waitlist_promotions (activity_id, user_id, waited_seconds) VALUES (?, ?, ?)");
+    promotionQuery.addBindValue(activityId);
+    promotionQuery.addBindValue(userId);
+    promotionQuery.addBindValue(head.waitedSeconds);
+    promotionQuery.exec();
 
     // 添加报名
     QSqlQuery enrollQuery(m_database);
@@ -585,28 +1582,749 @@ bool DatabaseManager::processWaitlist(int activityId)
     updateQuery.prepare("UPDATE activities SET current_participants = current_participants + 1 WHERE id = ?");
     updateQuery.addBindValue(activityId);
     updateQuery.exec();
+    invalidateActivityDetail(activityId);
 
     return true;
 }
 
+bool DatabaseManager::getWaitlistStatus(int userId, int activityId, WaitlistStatus& status)
+{
+    traceCall(TraceOp::GetWaitlistStatus, userId, activityId);
+    const TraceScope trace(m_traceDepth);
+
+    QSqlQuery query(m_database);
+    query.prepare(selectSql<WaitlistEntryRow>("WHERE w.user_id = ? AND w.activity_id = ?"));
+    query.addBindValue(userId);
+    query.addBindValue(activityId);
+    if (!query.exec() || !query.next()) {
+        return false;
+    }
+
+    WaitlistEntryRow entry;
+    readRow(query, entry);
+    status = WaitlistStatus();
+    status.activityId = entry.activityId;
+    status.title = entry.title;
+    status.startTime = entry.startTime;
+    fillWaitlistStatus(userId, status);
+    return status.position > 0;
+}
+
+QVector<WaitlistStatus> DatabaseManager::getWaitlistStatuses(int userId)
+{
+    traceCall(TraceOp::GetWaitlistStatuses, userId, -1);
+    const TraceScope trace(m_traceDepth);
+
+    QVector<WaitlistStatus> statuses;
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.prepare(selectSql<WaitlistEntryRow>("WHERE w.user_id = ? ORDER BY a.start_time ASC"));
+    query.addBindValue(userId);
+    if (!query.exec()) {
+        qDebug() << "Waitlist status query failed:" << query.lastError().text();
+        return statuses;
+    }
+
+    for (const WaitlistEntryRow& entry : fetchRows<WaitlistEntryRow>(query)) {
+        WaitlistStatus status;
+        status.activityId = entry.activityId;
+        status.title = entry.title;
+        status.startTime = entry.startTime;
+        statuses.append(status);
+    }
+
+    for (WaitlistStatus& status : statuses) {
+        fillWaitlistStatus(userId, status);
+    }
+    return statuses;
+}
+
+void DatabaseManager::fillWaitlistStatus(int userId, WaitlistStatus& status)
+{
+    // 名次来自内存中的树状数组，队列只在第一次查询（或其他进程修改后）从索引顺序读入一次
+    if (!m_waitlistIndex.isLoaded(status.activityId)) {
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+        query.prepare(selectSql<WaitlistQueueRow>("WHERE activity_id = ? ORDER BY added_at ASC, id ASC"));
+        query.addBindValue(status.activityId);
+        if (!query.exec()) {
+            return;
+        }
+        QVector<int> userIds;
+        WaitlistQueueRow row;
+        while (query.next()) {
+            readRow(query, row);
+            userIds.append(row.userId);
+        }
+        m_waitlistIndex.load(status.activityId, userIds);
+    }
+
+    status.position = m_waitlistIndex.position(status.activityId, userId);
+    status.queueLength = m_waitlistIndex.length(status.activityId);
+    status.promotionsPerDay = promotionRate(status.activityId);
+    if (status.position > 0 && status.promotionsPerDay > 0.0) {
+        const qint64 seconds = qint64(status.position / status.promotionsPerDay * 86400.0);
+        status.estimatedPromotion = formatTime(QDateTime::currentDateTime().addSecs(seconds));
+    }
+}
+
+double DatabaseManager::promotionRate(int activityId)
+{
+    // 本活动有足够的转正记录时，按第一次转正至今的平均速度计算
+    QSqlQuery query(m_database);
+    PromotionStatsRow stats;
+    query.prepare(selectSql<PromotionStatsRow>("WHERE activity_id = ?"));
+    query.addBindValue(activityId);
+    if (query.exec() && query.next()) {
+        readRow(query, stats);
+        if (stats.promotions >= kMinPromotionSamples) {
+            return stats.promotions / qMax(1.0, stats.days);
+        }
+    }
+
+    // 否则用最近30天内各活动的平均速度
+    if (query.exec(selectSql<PromotionStatsRow>("WHERE promoted_at >= datetime('now', '-30 days')")) && query.next()) {
+        readRow(query, stats);
+        if (stats.activities > 0) {
+            return double(stats.promotions) / stats.activities / 30.0;
+        }
+    }
+    return 0.0;
+}
+
 bool DatabaseManager::approveActivity(int activityId, int adminId)
 {
+    traceCall(TraceOp::Approve, adminId, activityId);
+    const TraceScope trace(m_traceDepth);
+
     QSqlQuery query(m_database);
     query.prepare("UPDATE activities SET status = 'approved', admin_id = ?, approved_at = ? WHERE id = ?");
     query.addBindValue(adminId);
     query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
     query.addBindValue(activityId);
 
+    invalidateActivityDetail(activityId);
     return query.exec();
 }
 
 bool DatabaseManager::rejectActivity(int activityId, int adminId, const QString& reason)
 {
+    traceCall(TraceOp::Reject, adminId, activityId, QList<int>(), { reason });
+    const TraceScope trace(m_traceDepth);
+
     QSqlQuery query(m_database);
     query.prepare("UPDATE activities SET status = 'rejected', admin_id = ?, rejected_reason = ? WHERE id = ?");
     query.addBindValue(adminId);
     query.addBindValue(reason);
     query.addBindValue(activityId);
 
+    invalidateActivityDetail(activityId);
     return query.exec();
 }
+
+QList<ReviewResult> DatabaseManager::approveActivities(const QList<int>& activityIds, int adminId)
+{
+    traceCall(TraceOp::ApproveBatch, adminId, -1, activityIds);
+    const TraceScope trace(m_traceDepth);
+
+    return reviewActivities(activityIds, adminId, true, QString());
+}
+
+QList<ReviewResult> DatabaseManager::rejectActivities(const QList<int>& activityIds, int adminId, const QString& reason)
+{
+    traceCall(TraceOp::RejectBatch, adminId, -1, activityIds, { reason });
+    const TraceScope trace(m_traceDepth);
+
+    return reviewActivities(activityIds, adminId, false, reason);
+}
+
+QList<ReviewResult> DatabaseManager::reviewActivities(const QList<int>& activityIds, int adminId,
+                                                      bool approve, const QString& reason)
+{
+    QList<ReviewResult> results;
+    if (activityIds.isEmpty()) {
+        return results;
+    }
+
+    QStringList idList;
+    for (int id : activityIds) {
+        idList << QString::number(id);
+    }
+    const QString inClause = "(" + idList.join(",") + ")";
+
+    if (!m_database.transaction()) {
+        qDebug() << "Failed to begin review transaction:" << m_database.lastError().text();
+        for (int id : activityIds) {
+            results.append({ id, false, "无法开始事务" });
+        }
+        return results;
+    }
+
+    // 一次查询所有活动的当前状态
+    QHash<int, QString> statuses;
+    QSqlQuery query(m_database);
+    if (query.exec("SELECT id, status FROM activities WHERE id IN " + inClause)) {
+        while (query.next()) {
+            statuses.insert(query.value(0).toInt(), query.value(1).toString());
+        }
+    }
+
+    QStringList pendingIds;
+    for (int id : activityIds) {
+        auto it = statuses.constFind(id);
+        if (it == statuses.constEnd()) {
+            results.append({ id, false, "活动不存在" });
+        } else if (it.value() != "pending") {
+            results.append({ id, false, "活动当前状态为" + it.value() + "，无需审批" });
+        } else {
+            results.append({ id, true, QString() });
+            pendingIds << QString::number(id);
+        }
+    }
+
+    for (const ReviewResult& result : results) {
+        if (result.success) {
+            invalidateActivityDetail(result.activityId);
+        }
+    }
+
+    if (!pendingIds.isEmpty()) {
+        const QString pendingClause = "(" + pendingIds.join(",") + ")";
+        if (approve) {
+            query.prepare("UPDATE activities SET status = 'approved', admin_id = ?, approved_at = ? "
+                          "WHERE status = 'pending' AND id IN " + pendingClause);
+            query.addBindValue(adminId);
+            query.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+        } else {
+            query.prepare("UPDATE activities SET status = 'rejected', admin_id = ?, rejected_reason = ? "
+                          "WHERE status = 'pending' AND id IN " + pendingClause);
+            query.addBindValue(adminId);
+            query.addBindValue(reason);
+        }
+
+        if (!query.exec() || !m_database.commit()) {
+            const QString error = query.lastError().isValid() ? query.lastError().text()
+                                                              : m_database.lastError().text();
+            qDebug() << "Batch review failed:" << error;
+            m_database.rollback();
+            for (ReviewResult& result : results) {
+                if (result.success) {
+                    result.success = false;
+                    result.reason = "数据库更新失败: " + error;
+                }
+            }
+        }
+    } else {
+        m_database.commit();
+    }
+
+    return results;
+}
+
+int DatabaseManager::archiveCompletedData(int retentionDays)
+{
+    traceCall(TraceOp::ArchiveCompleted, -1, -1, { retentionDays });
+    const TraceScope trace(m_traceDepth);
+
+    const QString cutoff = formatTime(QDateTime::currentDateTime().addDays(-retentionDays));
+    const QString archivedAt = formatTime(QDateTime::currentDateTime());
+
+    // 符合归档条件的活动
+    const QString expiredActivities =
+        "SELECT id FROM activities WHERE status IN ('completed', 'cancelled') AND end_time < ?";
+
+    if (!m_database.transaction()) {
+        qDebug() << "Failed to begin archive transaction:" << m_database.lastError().text();
+        return -1;
+    }
+
+    QSqlQuery query(m_database);
+    auto run = [&query](const QString& sql, const QVariantList& values) {
+        query.prepare(sql);
+        for (const QVariant& value : values) {
+            query.addBindValue(value);
+        }
+        if (!query.exec()) {
+            qDebug() << "Archive step failed:" << query.lastError().text();
+            return false;
+        }
+        return true;
+    };
+
+    int archivedActivities = 0;
+    int archivedEnrollments = 0;
+
+    bool ok =
+        // 旧版本遗留在热表中的取消记录
+        run(R"(
+            INSERT INTO enrollments_archive (id, user_id, activity_id, enrolled_at, status, archived_at)
+            SELECT id, user_id, activity_id, enrolled_at, status, ? FROM enrollments WHERE status = 'cancelled'
+        )", { archivedAt })
+        && run("DELETE FROM enrollments WHERE status = 'cancelled'", {})
+        // 已结束活动的报名记录
+        && run(R"(
+            INSERT INTO enrollments_archive (id, user_id, activity_id, enrolled_at, status, archived_at)
+            SELECT id, user_id, activity_id, enrolled_at, status, ? FROM enrollments
+            WHERE activity_id IN ()" + expiredActivities + ")", { archivedAt, cutoff });
+    if (ok) {
+        archivedEnrollments = query.numRowsAffected();
+        ok = run("DELETE FROM enrollments WHERE activity_id IN (" + expiredActivities + ")", { cutoff })
+            && run("DELETE FROM waitlist WHERE activity_id IN (" + expiredActivities + ")", { cutoff })
+            && run(R"(
+                INSERT INTO activities_archive (id, title, description, organizer_id, start_time, end_time,
+                       max_participants, current_participants, status, category, admin_id, approved_at,
+                       rejected_reason, created_at, archived_at)
+                SELECT id, title, description, organizer_id, start_time, end_time,
+                       max_participants, current_participants, status, category, admin_id, approved_at,
+                       rejected_reason, created_at, ?
+                FROM activities WHERE id IN ()" + expiredActivities + ")", { archivedAt, cutoff });
+    }
+    if (ok) {
+        archivedActivities = query.numRowsAffected();
+        ok = run("DELETE FROM activities WHERE id IN (" + expiredActivities + ")", { cutoff });
+    }
+    if (ok) {
+        // 变更日志只需保留到所有实例都轮询过为止
+        ok = run("DELETE FROM change_journal WHERE changed_at < ?",
+                 { formatTime(QDateTime::currentDateTimeUtc().addDays(-1)) });
+    }
+
+    if (!ok || !m_database.commit()) {
+        m_database.rollback();
+        return -1;
+    }
+
+    // 归档后的活动不再出现在热表中
+    m_detailCache.clear();
+    m_waitlistIndex.clear();
+
+    qDebug() << "Archived" << archivedActivities << "activities and" << archivedEnrollments << "enrollments";
+    return archivedActivities;
+}
+
+void DatabaseManager::startArchiveSchedule(int intervalMinutes, int retentionDays)
+{
+    m_archiveRetentionDays = retentionDays;
+
+    if (intervalMinutes <= 0) {
+        if (m_archiveTimer) {
+            m_archiveTimer->stop();
+        }
+        return;
+    }
+
+    if (!m_archiveTimer) {
+        m_archiveTimer = new QTimer(this);
+        connect(m_archiveTimer, &QTimer::timeout, this, [this]() {
+            archiveCompletedData(m_archiveRetentionDays);
+        });
+    }
+
+    m_archiveTimer->start(intervalMinutes * 60 * 1000);
+}
+
+bool DatabaseManager::pollChanges()
+{
+    QSqlQuery query(m_database);
+
+    // data_version只在其他连接提交后变化，调用代价几乎为零
+    // 分片模式下变更日志位于当前学期分片，检查该库的版本
+    if (!query.exec("PRAGMA " + m_termPrefix + "data_version") || !query.next()) {
+        return false;
+    }
+    const qint64 version = query.value(0).toLongLong();
+    if (version == m_dataVersion) {
+        return false;
+    }
+    m_dataVersion = version;
+
+    query.prepare("SELECT seq, entity, entity_id FROM change_journal WHERE seq > ? ORDER BY seq");
+    query.addBindValue(m_lastJournalSeq);
+    if (!query.exec()) {
+        qDebug() << "Failed to read change journal:" << query.lastError().text();
+        return false;
+    }
+
+    QSet<int> activityIds;
+    QSet<int> enrollmentActivityIds;
+    QSet<int> seriesIds;
+    while (query.next()) {
+        m_lastJournalSeq = query.value(0).toLongLong();
+        const QString entity = query.value(1).toString();
+        const int entityId = query.value(2).toInt();
+
+        // 周期活动记录的是系列ID，与活动ID不在同一空间
+        if (entity == "series") {
+            seriesIds.insert(entityId);
+            continue;
+        }
+
+        // 报名变化会改变参与人数，同样需要失效活动详情
+        invalidateActivityDetail(entityId);
+        if (entity == "activity") {
+            activityIds.insert(entityId);
+        } else {
+            enrollmentActivityIds.insert(entityId);
+        }
+        // 候补队列的名次索引无法从日志得知具体变化，丢弃后在下次查询时重新装入
+        if (entity == "waitlist") {
+            m_waitlistIndex.invalidate(entityId);
+        }
+    }
+
+    if (!activityIds.isEmpty()) {
+        emit activitiesChanged(activityIds.values());
+    }
+    if (!enrollmentActivityIds.isEmpty()) {
+        emit enrollmentsChanged(enrollmentActivityIds.values());
+    }
+    if (!seriesIds.isEmpty()) {
+        emit seriesChanged(seriesIds.values());
+    }
+
+    return !activityIds.isEmpty() || !enrollmentActivityIds.isEmpty() || !seriesIds.isEmpty();
+}
+
+void DatabaseManager::startChangePolling(int intervalMs)
+{
+    if (intervalMs <= 0) {
+        if (m_changeTimer) {
+            m_changeTimer->stop();
+        }
+        return;
+    }
+
+    if (!m_changeTimer) {
+        m_changeTimer = new QTimer(this);
+        connect(m_changeTimer, &QTimer::timeout, this, &DatabaseManager::pollChanges);
+    }
+
+    m_changeTimer->start(intervalMs);
+}
+
+int DatabaseManager::schemaVersion(const QString& schema)
+{
+    QSqlQuery query(m_database);
+    if (query.exec(QString("PRAGMA %1.user_version").arg(schema)) && query.next()) {
+        return query.value(0).toInt();
+    }
+    return 0;
+}
+
+void DatabaseManager::setSchemaVersion(const QString& schema)
+{
+    QSqlQuery query(m_database);
+    query.exec(QString("PRAGMA %1.user_version = %2").arg(schema).arg(kSchemaVersion));
+}
+
+QString DatabaseManager::termForDate(const QDate& date)
+{
+    // 2-7月为春季学期，8-12月为秋季学期，1月仍属上一年秋季学期
+    if (date.month() == 1) {
+        return QString("%1fall").arg(date.year() - 1);
+    }
+    return QString("%1%2").arg(date.year()).arg(date.month() >= 8 ? "fall" : "spring");
+}
+
+QString DatabaseManager::termFilePath(const QString& term) const
+{
+    QFileInfo mainFile(m_database.databaseName());
+    return mainFile.absoluteDir().filePath(QString("%1_%2.db").arg(mainFile.completeBaseName(), term));
+}
+
+QStringList DatabaseManager::availableTerms() const
+{
+    QFileInfo mainFile(m_database.databaseName());
+    const QString prefix = mainFile.completeBaseName() + "_";
+
+    QStringList terms;
+    const QStringList files = mainFile.absoluteDir().entryList({ prefix + "*.db" }, QDir::Files, QDir::Name);
+    for (const QString& file : files) {
+        const QString term = file.mid(prefix.size(), file.size() - prefix.size() - 3);
+        if (isValidTerm(term)) {
+            terms << term;
+        }
+    }
+    return terms;
+}
+
+bool DatabaseManager::isValidTerm(const QString& term)
+{
+    // 学期名会拼进库名，只允许字母、数字和下划线
+    static const QRegularExpression pattern("^[A-Za-z0-9_]+$");
+    return pattern.match(term).hasMatch();
+}
+
+bool DatabaseManager::attachTerm(const QString& term)
+{
+    if (m_attachedTerms.contains(term)) {
+        return true;
+    }
+    if (!isValidTerm(term)) {
+        qDebug() << "Invalid term name:" << term;
+        return false;
+    }
+
+    const QString schema = "term_" + term;
+    QSqlQuery query(m_database);
+    query.prepare(QString("ATTACH DATABASE ? AS %1").arg(schema));
+    query.addBindValue(termFilePath(term));
+    if (!query.exec()) {
+        qDebug() << "Failed to attach term" << term << ":" << query.lastError().text();
+        return false;
+    }
+    m_attachedTerms << term;
+
+    // 新学期文件在附加时创建，建表和分配ID号段只在版本不一致时执行
+    if (schemaVersion(schema) != kSchemaVersion) {
+        if (!createTermTables(schema + ".") || !assignTermIdBlock(term, schema)) {
+            return false;
+        }
+        setSchemaVersion(schema);
+    }
+
+    if (term == m_activeTerm) {
+        m_termPrefix = schema + ".";
+    }
+    return true;
+}
+
+bool DatabaseManager::assignTermIdBlock(const QString& term, const QString& schema)
+{
+    // 各分片的自增ID各自从1开始会在学期之间重复，而缓存、变更日志、候补索引和报表导出都只按活动ID区分。
+    // 因此每个学期在共享主库中登记一个号段，活动和系列ID从号段起点开始分配，第一个登记的学期为号段0
+    QSqlQuery query(m_database);
+    if (!query.exec("CREATE TABLE IF NOT EXISTS main.term_id_blocks (term TEXT PRIMARY KEY, block INTEGER NOT NULL UNIQUE)")) {
+        qDebug() << "Failed to create term id blocks:" << query.lastError().text();
+        return false;
+    }
+
+    query.prepare(R"(
+        INSERT OR IGNORE INTO main.term_id_blocks (term, block)
+        SELECT ?, COALESCE(MAX(block) + 1, 0) FROM main.term_id_blocks
+    )");
+    query.addBindValue(term);
+    if (!query.exec()) {
+        qDebug() << "Failed to assign id block for term" << term << ":" << query.lastError().text();
+        return false;
+    }
+
+    query.prepare("SELECT block FROM main.term_id_blocks WHERE term = ?");
+    query.addBindValue(term);
+    if (!query.exec() || !query.next()) {
+        qDebug() << "No id block for term" << term << ":" << query.lastError().text();
+        return false;
+    }
+    const qint64 base = query.value(0).toLongLong() * kTermIdBlockSize;
+    if (base == 0) {
+        return true;
+    }
+
+    // 引入号段之前创建的分片ID从1开始，整体移入本学期号段（未启用外键，父子表逐个更新即可）
+    const QStringList shifts = {
+        "UPDATE %1.activities SET id = id + %2 WHERE id < %2",
+        "UPDATE %1.activities_archive SET id = id + %2 WHERE id < %2",
+        "UPDATE %1.enrollments SET activity_id = activity_id + %2 WHERE activity_id < %2",
+        "UPDATE %1.enrollments_archive SET activity_id = activity_id + %2 WHERE activity_id < %2",
+        "UPDATE %1.waitlist SET activity_id = activity_id + %2 WHERE activity_id < %2",
+        "UPDATE %1.waitlist_promotions SET activity_id = activity_id + %2 WHERE activity_id < %2",
+        "UPDATE %1.activity_series SET id = id + %2 WHERE id < %2",
+        "UPDATE %1.series_occurrences SET series_id = series_id + %2 WHERE series_id < %2",
+        "UPDATE %1.series_enrollments SET series_id = series_id + %2 WHERE series_id < %2"
+    };
+
+    if (!m_database.transaction()) {
+        return false;
+    }
+
+    bool ok = true;
+    for (const QString& sql : shifts) {
+        ok = ok && query.exec(sql.arg(schema).arg(base));
+    }
+
+    // 自增序列不低于号段起点；表中还没有行时sqlite_sequence里也没有对应项，需要插入
+    for (const QString& table : { "activities", "activity_series" }) {
+        if (!ok) {
+            break;
+        }
+        query.prepare(QString("UPDATE %1.sqlite_sequence SET seq = MAX(seq, ?) WHERE name = ?").arg(schema));
+        query.addBindValue(base);
+        query.addBindValue(table);
+        ok = query.exec();
+        if (ok && query.numRowsAffected() == 0) {
+            query.prepare(QString("INSERT INTO %1.sqlite_sequence (name, seq) VALUES (?, ?)").arg(schema));
+            query.addBindValue(table);
+            query.addBindValue(base);
+            ok = query.exec();
+        }
+    }
+
+    if (!ok || !m_database.commit()) {
+        qDebug() << "Failed to move term" << term << "into its id block:" << query.lastError().text();
+        m_database.rollback();
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseManager::detachAllTerms()
+{
+    QSqlQuery query(m_database);
+    for (const QString& term : m_attachedTerms) {
+        if (!query.exec(QString("DETACH DATABASE term_%1").arg(term))) {
+            qDebug() << "Failed to detach term" << term << ":" << query.lastError().text();
+            return false;
+        }
+    }
+    m_attachedTerms.clear();
+    m_termPrefix.clear();
+    return true;
+}
+
+bool DatabaseManager::migrateLegacyTables()
+{
+    // 未分片时的业务表位于主库，会遮蔽分片中的同名表，首次启用分片时整体迁入当前学期
+    QSqlQuery query(m_database);
+    if (!query.exec("SELECT COUNT(*) FROM main.sqlite_master WHERE type = 'table' AND name = 'activities'")
+        || !query.next() || query.value(0).toInt() == 0) {
+        return true;
+    }
+
+    qDebug() << "Migrating legacy tables into term" << m_activeTerm;
+    // 旧版本的主库可能还没有后来新增的表，只迁移实际存在的
+    QStringList tables;
+    for (const QString& table : { "activities", "enrollments", "waitlist", "waitlist_promotions",
+                                  "activities_archive", "enrollments_archive",
+                                  "activity_series", "series_occurrences", "series_enrollments" }) {
+        query.prepare("SELECT COUNT(*) FROM main.sqlite_master WHERE type = 'table' AND name = ?");
+        query.addBindValue(table);
+        if (query.exec() && query.next() && query.value(0).toInt() > 0) {
+            tables << table;
+        }
+    }
+
+    if (!m_database.transaction()) {
+        return false;
+    }
+
+    bool ok = true;
+    for (const QString& table : tables) {
+        ok = ok && query.exec(QString("INSERT INTO %1%2 SELECT * FROM main.%2").arg(m_termPrefix, table));
+    }
+    ok = ok && query.exec("DROP VIEW IF EXISTS main.all_activities")
+            && query.exec("DROP VIEW IF EXISTS main.all_enrollments")
+            && query.exec("DROP TABLE IF EXISTS main.change_journal");
+    for (const QString& table : tables) {
+        ok = ok && query.exec(QString("DROP TABLE IF EXISTS main.%1").arg(table));
+    }
+
+    if (!ok || !m_database.commit()) {
+        qDebug() << "Failed to migrate legacy tables:" << query.lastError().text();
+        m_database.rollback();
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseManager::rolloverTerm(const QString& newTerm)
+{
+    if (!m_shardingEnabled || !isValidTerm(newTerm)) {
+        return false;
+    }
+
+    // 切换学期只是换一个分片文件：先全部分离，再让新学期最先附加
+    if (!detachAllTerms()) {
+        return false;
+    }
+
+    const QString previousTerm = m_activeTerm;
+    m_activeTerm = newTerm;
+    if (!attachTerm(newTerm)) {
+        m_activeTerm = previousTerm;
+        attachTerm(previousTerm);
+        return false;
+    }
+
+    m_detailCache.clear();
+    m_waitlistIndex.clear();
+    initChangeTracking();
+    qDebug() << "Rolled over from term" << previousTerm << "to" << newTerm;
+    return true;
+}
+
+QList<TermDatabase> DatabaseManager::termDatabases()
+{
+    QList<TermDatabase> databases;
+    if (!m_shardingEnabled) {
+        return databases;
+    }
+
+    // 历史学期按需附加，排在当前学期之后（SQLite默认最多附加10个库）
+    for (const QString& term : availableTerms()) {
+        if (!m_attachedTerms.contains(term) && m_attachedTerms.size() >= kMaxAttachedTerms) {
+            qDebug() << "Too many term shards, skipping" << term;
+            continue;
+        }
+        attachTerm(term);
+    }
+    for (const QString& term : m_attachedTerms) {
+        databases.append({ "term_" + term, termFilePath(term) });
+    }
+    return databases;
+}
+
+bool DatabaseManager::attachTermDatabases(QSqlDatabase& db, const QList<TermDatabase>& databases)
+{
+    QSqlQuery query(db);
+    for (const TermDatabase& term : databases) {
+        query.prepare(QString("ATTACH DATABASE ? AS %1").arg(term.schema));
+        query.addBindValue(term.fileName);
+        if (!query.exec()) {
+            qDebug() << "Failed to attach" << term.fileName << ":" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+QString DatabaseManager::fanOutSql(const QString& selectTemplate, const QString& orderBy)
+{
+    QStringList parts;
+    if (!m_shardingEnabled) {
+        parts << QString(selectTemplate).replace("$term.", QString());
+    } else {
+        for (const TermDatabase& term : termDatabases()) {
+            parts << QString(selectTemplate).replace("$term.", term.schema + ".");
+        }
+    }
+
+    // 复合查询的ORDER BY只能放在最外层，统一包一层子查询
+    QString sql = "SELECT * FROM (" + parts.join(" UNION ALL ") + ")";
+    if (!orderBy.isEmpty()) {
+        sql += " ORDER BY " + orderBy;
+    }
+    return sql;
+}
+
+bool DatabaseManager::startRecording(const QString& fileName)
+{
+    if (!m_recorder) {
+        m_recorder = new OperationRecorder;
+    }
+    return m_recorder->start(fileName);
+}
+
+void DatabaseManager::stopRecording()
+{
+    delete m_recorder;
+    m_recorder = nullptr;
+}
+
+void DatabaseManager::traceCall(TraceOp op, int userId, int activityId,
+                                const QList<int>& ids, const QStringList& text)
+{
+    if (m_recorder && m_traceDepth == 0) {
+        m_recorder->record(op, userId, activityId, ids, text);
+    }
+}
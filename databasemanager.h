@@ -6,7 +6,99 @@
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QString>
+#include <QDateTime>
+#include <QDate>
+#include <QStringList>
+#include <QList>
+#include <QVariantList>
+#include <QVector>
+#include <QCache>
+#include "rowtypes.h"
+#include "waitlistindex.h"
 
+class QTimer;
+class OperationRecorder;
+enum class TraceOp : quint8;
+
+// 批量审批中单个活动的处理结果
+struct ReviewResult
+{
+    int activityId;
+    bool success;
+    QString reason;    // 失败原因
+};
+
+// 活动详情记录（详情面板使用，缓存于DatabaseManager），字段与ActivityRow一致
+using ActivityDetail = ActivityRow;
+
+// 活动详情缓存统计
+struct DetailCacheStats
+{
+    qint64 hits = 0;
+    qint64 misses = 0;
+    int entries = 0;
+    qint64 bytes = 0;        // 缓存记录占用的估算内存
+    double hitRate = 0.0;
+};
+
+// 学生视角下活动的可报名状态
+enum class Availability : quint8 {
+    Available = 0,   // 可报名
+    Conflict,        // 与已报名活动时间冲突
+    Enrolled,        // 已报名
+    Waitlisted,      // 已在候补队列
+    Full             // 已满员（报名将进入候补）
+};
+
+// 学生活动列表中带可报名标注的一行
+struct StudentActivityRow
+{
+    int id = -1;
+    QString title;
+    QString organizerName;
+    QString startTime;
+    QString endTime;
+    int maxParticipants = 0;
+    int currentParticipants = 0;
+    QString status;
+    QString category;
+    Availability availability = Availability::Available;
+};
+
+// 一个学期分片库（库名及文件路径），供其他连接按相同库名附加
+struct TermDatabase
+{
+    QString schema;
+    QString fileName;
+};
+
+// 周期活动的一场（由规则按需展开，不对应activities中的行）
+struct ActivityOccurrence
+{
+    int seriesId = -1;
+    int occurrenceIndex = 0;
+    QString title;
+    QString organizerName;
+    QString startTime;
+    QString endTime;
+    int maxParticipants = 0;        // 单场容量（未单独设置时为系列容量）
+    int currentParticipants = 0;
+    QString status;
+    QString category;
+    bool rescheduled = false;       // 是否为改期后的时间
+};
+
+// 学生在某个活动候补队列中的位置及转正估计
+struct WaitlistStatus
+{
+    int activityId = -1;
+    QString title;
+    QString startTime;
+    int position = 0;               // 从1开始，不在队列中为0
+    int queueLength = 0;
+    double promotionsPerDay = 0.0;  // 历史转正速度（人/天），没有历史记录时为0
+    QString estimatedPromotion;     // 预计转正时间，无法估计时为空
+};
 
 /**
  * @brief 数据库管理单例类
@@ -20,11 +112,29 @@ public:
     // 单例模式获取实例
     static DatabaseManager& instance();
     
+    // 指定数据库文件（需在initialize之前调用，默认为程序目录下的campus_activity.db）
+    void setDatabasePath(const QString& path) { m_databasePathOverride = path; }
+    
+    // 按学期分片：主库只保存用户，每个学期一个分片文件并以 term_<学期> 附加
+    // （需在initialize之前调用；activeTerm为空时按当前日期推算）
+    void setShardingEnabled(bool enabled) { m_shardingEnabled = enabled; }
+    void setActiveTerm(const QString& term) { m_activeTerm = term; }
+    bool isShardingEnabled() const { return m_shardingEnabled; }
+    QString activeTerm() const { return m_activeTerm; }
+    static QString termForDate(const QDate& date);
+    
+    // 默认数据库文件路径：程序目录下的campus_activity.db（需要在QApplication创建之后调用）
+    static QString databasePath();
+    
     // 初始化数据库连接和表结构
     bool initialize();
     
     // 获取数据库连接
     QSqlDatabase database() const { return m_database; }
+
+    // 活动时间的统一存储格式（yyyy-MM-dd HH:mm:ss），字符串比较即时间比较
+    static QDateTime parseTime(const QString& text);
+    static QString formatTime(const QDateTime& time);
     
     // 用户相关操作
     bool authenticateUser(const QString& username, const QString& password, QString& role);
@@ -35,23 +145,101 @@ public:
                       const QString& organizer, const QString& startTime, 
                       const QString& endTime, int maxParticipants, const QString& category);
     bool updateActivityStatus(int activityId, const QString& status);
-    QSqlQuery getActivities(const QString& role = "", int userId = -1);
+    // 列表投影（ActivityListRow），activityIds非空时只查询这些活动（用于增量刷新）
+    QSqlQuery getActivities(const QString& role = "", int userId = -1,
+                            const QList<int>& activityIds = QList<int>());
+    // 分页读取列表投影：afterId为上一页最后一行的ID（第一页传-1），每页最多limit行。
+    // 每页是独立的短查询，页与页之间不持有读事务
+    QSqlQuery getActivityPage(const QString& role, int userId, int afterId, int limit);
+    // 详情投影（ActivityRow），含描述
     QSqlQuery getActivityById(int activityId);
     
+    // 带LRU缓存的活动详情查询，写操作会精确失效对应条目
+    bool getActivityDetail(int activityId, ActivityDetail& detail);
+    void setDetailCacheLimit(qint64 bytes);
+    DetailCacheStats detailCacheStats() const;
+    
+    // 时间轴：与 [from, to) 有交集的活动，按开始时间排序（角色过滤同getActivities）
+    std::vector<TimelineRow> getActivitiesInRange(const QString& from, const QString& to,
+                                                  const QString& role = "", int userId = -1);
+    // 最早和最晚的活动开始时间，没有活动时返回false
+    bool getActivityTimeBounds(QString& earliest, QString& latest);
+    
+    // 学生活动列表：一次查询取回已审批活动及本人报名/候补标记，
+    // 再对按开始时间排序的日程做一次扫描线标注冲突
+    QVector<StudentActivityRow> getStudentActivityListing(int userId);
+    
     // 报名相关操作
     bool enrollActivity(int userId, int activityId, bool& hasConflict, QString& conflictInfo);
     bool cancelEnrollment(int userId, int activityId);
     bool checkTimeConflict(int userId, const QString& startTime, const QString& endTime, int excludeActivityId = -1);
     QSqlQuery getEnrollments(int activityId = -1, int userId = -1);
     
+    // 周期活动系列：一行规则（首场时间、间隔天数、场数），每场单独报名和计算容量
+    int createActivitySeries(const QString& title, const QString& description,
+                             const QString& organizer, const QString& firstStart,
+                             const QString& firstEnd, int intervalDays, int occurrenceCount,
+                             int maxParticipants, const QString& category);
+    bool updateSeriesStatus(int seriesId, const QString& status);
+    // 单场例外：取消、改期、单独设置容量
+    bool cancelOccurrence(int seriesId, int occurrenceIndex);
+    bool rescheduleOccurrence(int seriesId, int occurrenceIndex, const QString& startTime, const QString& endTime);
+    bool setOccurrenceCapacity(int seriesId, int occurrenceIndex, int maxParticipants);
+    // 只展开与 [from, to) 有交集的场次，按开始时间排序
+    QVector<ActivityOccurrence> getOccurrences(const QString& from, const QString& to,
+                                               const QString& role = "", int userId = -1);
+    bool enrollOccurrence(int userId, int seriesId, int occurrenceIndex, bool& hasConflict, QString& conflictInfo);
+    bool cancelOccurrenceEnrollment(int userId, int seriesId, int occurrenceIndex);
+    
     // 候补队列操作
     bool addToWaitlist(int userId, int activityId);
     bool processWaitlist(int activityId);
+    // 候补名次（O(log n)，与队列长度无关）及按历史转正速度估计的转正时间
+    bool getWaitlistStatus(int userId, int activityId, WaitlistStatus& status);
+    QVector<WaitlistStatus> getWaitlistStatuses(int userId);
     
     // 管理员审批操作
     bool approveActivity(int activityId, int adminId);
     bool rejectActivity(int activityId, int adminId, const QString& reason);
 
+    // 批量审批：在一个事务内用一条UPDATE处理所有待审批活动，返回每个ID的结果
+    QList<ReviewResult> approveActivities(const QList<int>& activityIds, int adminId);
+    QList<ReviewResult> rejectActivities(const QList<int>& activityIds, int adminId, const QString& reason);
+    
+    // 归档操作：把结束超过retentionDays天的已完成/已取消活动及其报名记录移入归档表
+    // 返回归档的活动数量，失败返回-1
+    int archiveCompletedData(int retentionDays = 30);
+    // 定时归档（intervalMinutes <= 0 表示停止）
+    void startArchiveSchedule(int intervalMinutes, int retentionDays = 30);
+    
+    // 学期分片路由：未限定库名的SQL访问当前学期；历史查询用fanOutSql展开到所有学期
+    QStringList availableTerms() const;
+    // 切换到新学期：只是分离旧分片、附加新分片文件
+    bool rolloverTerm(const QString& newTerm);
+    // 把模板中的 "$term." 替换为各学期库名并UNION ALL，未分片时去掉前缀
+    QString fanOutSql(const QString& selectTemplate, const QString& orderBy = QString());
+    // 附加全部学期并返回列表，用于其他线程的连接
+    QList<TermDatabase> termDatabases();
+    static bool attachTermDatabases(QSqlDatabase& db, const QList<TermDatabase>& databases);
+    
+    // 操作轨迹：把公开接口调用连同参数和时间写入二进制文件，供TraceReplayer回放
+    bool startRecording(const QString& fileName);
+    void stopRecording();
+    bool isRecording() const { return m_recorder != nullptr; }
+    
+    // 变更日志：检查其他进程写入的变更，失效对应缓存并发出变更信号
+    // 先用PRAGMA data_version快速判断，无外部写入时不查询日志表；有变更返回true
+    bool pollChanges();
+    void startChangePolling(int intervalMs);
+
+signals:
+    // 其他进程修改了这些活动（基本信息或状态）
+    void activitiesChanged(const QList<int>& activityIds);
+    // 这些活动的报名或候补队列发生变化
+    void enrollmentsChanged(const QList<int>& activityIds);
+    // 这些周期活动系列的规则、场次或场次报名发生变化
+    void seriesChanged(const QList<int>& seriesIds);
+
 private:
     explicit DatabaseManager(QObject *parent = nullptr);
     ~DatabaseManager();
@@ -61,17 +249,68 @@ private:
     DatabaseManager& operator=(const DatabaseManager&) = delete;
     
     // 创建表结构
-    bool createTables();
+    // prefix为空时建在主库，否则为 "term_<学期>." 建在对应分片
+    bool createTermTables(const QString& prefix);
     bool createUsersTable();
-    bool createActivitiesTable();
-    bool createEnrollmentsTable();
-    bool createWaitlistTable();
+    bool createActivitiesTable(const QString& prefix);
+    bool createEnrollmentsTable(const QString& prefix);
+    bool createWaitlistTable(const QString& prefix);
+    bool createArchiveTables(const QString& prefix);
+    bool createSeriesTables(const QString& prefix);
+    bool createChangeJournal(const QString& prefix);
+    static QString qualifyDdl(const QString& sql, const QString& prefix);
+    int schemaVersion(const QString& schema);
+    void setSchemaVersion(const QString& schema);
+    
+    // 按需创建场次记录后更新assignments中的列（"列 = ?"形式，values依次绑定）
+    bool updateOccurrence(int seriesId, int occurrenceIndex, const QString& assignments, const QVariantList& values);
+    
+    // 学期分片
+    static bool isValidTerm(const QString& term);
+    QString termFilePath(const QString& term) const;
+    bool attachTerm(const QString& term);
+    // 为学期分配全局唯一的ID号段，并把活动和系列的自增序列移到号段起点
+    bool assignTermIdBlock(const QString& term, const QString& schema);
+    bool detachAllTerms();
+    bool migrateLegacyTables();
+    void initChangeTracking();
+    
+    // 录制中且为最外层调用时记录一次操作
+    void traceCall(TraceOp op, int userId, int activityId,
+                   const QList<int>& ids = QList<int>(), const QStringList& text = QStringList());
+
+    
+    QList<ReviewResult> reviewActivities(const QList<int>& activityIds, int adminId,
+                                         bool approve, const QString& reason);
+
+    void invalidateActivityDetail(int activityId);
+    
+    // 按需装入队列后填写名次和转正估计
+    void fillWaitlistStatus(int userId, WaitlistStatus& status);
+    // 转正速度（人/天）：本活动的历史记录不足时用近期全部活动的平均值
+    double promotionRate(int activityId);
     
     // 初始化测试数据
     void initTestData();
     
     QSqlDatabase m_database;
+    QString m_databasePathOverride;
     bool m_initialized;
+    bool m_shardingEnabled;
+    QString m_activeTerm;
+    QString m_termPrefix;           // 当前学期库名前缀，未分片时为空
+    QStringList m_attachedTerms;    // 按附加顺序，当前学期在最前
+    OperationRecorder *m_recorder;  // 未录制时为空
+    int m_traceDepth;               // 当前公开调用的嵌套层数
+    QTimer *m_archiveTimer;
+    QCache<int, ActivityDetail> m_detailCache;   // 成本为记录的估算字节数
+    qint64 m_detailCacheHits;
+    qint64 m_detailCacheMisses;
+    WaitlistIndex m_waitlistIndex;  // 查询过的活动的候补名次
+    QTimer *m_changeTimer;
+    qint64 m_dataVersion;        // 最近一次读到的PRAGMA data_version
+    qint64 m_lastJournalSeq;     // 已处理的最大日志序号
+    int m_archiveRetentionDays;
 };
 
 #endif // DATABASEMANAGER_H
@@ -0,0 +1,204 @@
+//【阶段26：2024-07-01】只读快照的导出和映射
+
+#include "kiosksnapshot.h"
+#include "databasemanager.h"
+#include <QSaveFile>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QHash>
+#include <QVector>
+#include <QDateTime>
+#include <QDebug>
+
+static_assert(sizeof(KioskSnapshot::Header) == 56, "KioskSnapshot::Header layout is part of the file format");
+static_assert(sizeof(KioskSnapshot::Record) == 40, "KioskSnapshot::Record layout is part of the file format");
+
+namespace {
+
+quint64 align8(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+// 补零到offset处
+bool padTo(QSaveFile& file, quint64 offset)
+{
+    const qint64 padding = qint64(offset) - file.pos();
+    return padding <= 0 || file.write(QByteArray(int(padding), '\0')) == padding;
+}
+
+}
+
+KioskSnapshot::~KioskSnapshot()
+{
+    close();
+}
+
+int KioskSnapshot::exportApproved(const QString& fileName, QString& error)
+{
+    QSqlQuery query(DatabaseManager::instance().database());
+    query.setForwardOnly(true);
+    if (!query.exec(selectSql<ActivityListRow>("WHERE a.status = 'approved' ORDER BY a.start_time"))) {
+        error = query.lastError().text();
+        return -1;
+    }
+
+    // 字符串去重后依次放入字符数据，offsets[i]为第i个字符串的起始位置
+    QVector<Record> records;
+    QHash<QString, quint32> stringIds;
+    QVector<quint32> offsets;
+    QString stringData;
+    auto stringId = [&](const QString& value) {
+        auto it = stringIds.constFind(value);
+        if (it != stringIds.constEnd()) {
+            return it.value();
+        }
+        const quint32 id = quint32(offsets.size());
+        offsets.append(quint32(stringData.size()));
+        stringData += value;
+        stringIds.insert(value, id);
+        return id;
+    };
+
+    while (query.next()) {
+        ActivityListRow row;
+        readRow(query, row);
+
+        Record record = {};
+        record.startTime = DatabaseManager::parseTime(row.startTime).toSecsSinceEpoch();
+        record.endTime = DatabaseManager::parseTime(row.endTime).toSecsSinceEpoch();
+        record.id = row.id;
+        record.maxParticipants = row.maxParticipants;
+        record.currentParticipants = row.currentParticipants;
+        record.title = stringId(row.title);
+        record.organizer = stringId(row.organizerName);
+        record.category = stringId(row.category);
+        records.append(record);
+    }
+    offsets.append(quint32(stringData.size()));
+
+    Header header = {};
+    header.magic = Magic;
+    header.version = Version;
+    header.recordSize = sizeof(Record);
+    header.recordCount = quint32(records.size());
+    header.stringCount = quint32(offsets.size() - 1);
+    header.recordsOffset = align8(sizeof(Header));
+    header.stringIndexOffset = align8(header.recordsOffset + quint64(records.size()) * sizeof(Record));
+    header.stringDataOffset = align8(header.stringIndexOffset + quint64(offsets.size()) * sizeof(quint32));
+    header.fileSize = header.stringDataOffset + quint64(stringData.size()) * sizeof(QChar);
+    header.generatedAt = QDateTime::currentSecsSinceEpoch();
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = file.errorString();
+        return -1;
+    }
+
+    const bool written =
+        file.write(reinterpret_cast<const char *>(&header), sizeof(Header)) == qint64(sizeof(Header))
+        && padTo(file, header.recordsOffset)
+        && file.write(reinterpret_cast<const char *>(records.constData()),
+                      qint64(records.size()) * sizeof(Record)) == qint64(records.size()) * qint64(sizeof(Record))
+        && padTo(file, header.stringIndexOffset)
+        && file.write(reinterpret_cast<const char *>(offsets.constData()),
+                      qint64(offsets.size()) * sizeof(quint32)) == qint64(offsets.size()) * qint64(sizeof(quint32))
+        && padTo(file, header.stringDataOffset)
+        && file.write(reinterpret_cast<const char *>(stringData.constData()),
+                      qint64(stringData.size()) * sizeof(QChar)) == qint64(stringData.size()) * qint64(sizeof(QChar));
+
+    if (!written || !file.commit()) {
+        error = file.errorString();
+        return -1;
+    }
+
+    qDebug() << "Kiosk snapshot" << fileName << ":" << records.size() << "activities,"
+             << header.stringCount << "strings," << header.fileSize << "bytes";
+    return records.size();
+}
+
+bool KioskSnapshot::open(const QString& fileName, QString& error)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        error = m_file.errorString();
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    const uchar *map = size >= qint64(sizeof(Header)) ? m_file.map(0, size) : nullptr;
+    if (!map) {
+        error = size < qint64(sizeof(Header)) ? "快照文件不完整" : m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    // 只校验头部和各段边界，记录和字符串在读取时直接使用
+    const Header *header = reinterpret_cast<const Header *>(map);
+    const quint64 recordsEnd = header->recordsOffset + quint64(header->recordCount) * sizeof(Record);
+    const quint64 indexEnd = header->stringIndexOffset + (quint64(header->stringCount) + 1) * sizeof(quint32);
+    bool valid = header->magic == Magic && header->version == Version
+        && header->recordSize == sizeof(Record) && header->fileSize == quint64(size)
+        && header->recordsOffset % 8 == 0 && header->stringIndexOffset % 8 == 0 && header->stringDataOffset % 8 == 0
+        && header->recordsOffset >= sizeof(Header) && recordsEnd <= header->stringIndexOffset
+        && indexEnd <= header->stringDataOffset && header->stringDataOffset <= quint64(size);
+
+    if (valid) {
+        const quint32 *index = reinterpret_cast<const quint32 *>(map + header->stringIndexOffset);
+        m_stringDataSize = quint32((quint64(size) - header->stringDataOffset) / sizeof(QChar));
+        valid = index[header->stringCount] <= m_stringDataSize;
+    }
+
+    if (!valid) {
+        error = "不是有效的快照文件或版本不匹配";
+        m_file.unmap(const_cast<uchar *>(map));
+        m_file.close();
+        return false;
+    }
+
+    m_map = map;
+    m_header = header;
+    m_records = reinterpret_cast<const Record *>(map + header->recordsOffset);
+    m_stringIndex = reinterpret_cast<const quint32 *>(map + header->stringIndexOffset);
+    m_stringData = reinterpret_cast<const QChar *>(map + header->stringDataOffset);
+    m_recordCount = int(header->recordCount);
+    m_stringCount = header->stringCount;
+    return true;
+}
+
+void KioskSnapshot::close()
+{
+    if (m_map) {
+        m_file.unmap(const_cast<uchar *>(m_map));
+    }
+    m_file.close();
+
+    m_map = nullptr;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_stringIndex = nullptr;
+    m_stringData = nullptr;
+    m_recordCount = 0;
+    m_stringCount = 0;
+    m_stringDataSize = 0;
+}
+
+qint64 KioskSnapshot::generatedAt() const
+{
+    return m_header ? m_header->generatedAt : 0;
+}
+
+QString KioskSnapshot::string(quint32 index) const
+{
+    if (index >= m_stringCount) {
+        return QString();
+    }
+    const quint32 begin = m_stringIndex[index];
+    const quint32 end = m_stringIndex[index + 1];
+    if (begin > end || end > m_stringDataSize) {
+        return QString();
+    }
+    return QString::fromRawData(m_stringData + begin, qsizetype(end - begin));
+}
@@ -0,0 +1,94 @@
+#ifndef KIOSKSNAPSHOT_H
+#define KIOSKSNAPSHOT_H
+
+#include <QString>
+#include <QFile>
+
+//【阶段26：2024-07-01】自助查询机使用的只读快照：导出为定长记录的二进制文件，运行时直接映射读取
+
+/**
+ * @brief 只读活动快照
+ * 文件由文件头、定长记录数组和字符串表三段组成，各段按8字节对齐，按本机字节序（小端）存储，
+ * 字节序不同的机器上魔数对不上而拒绝打开：
+ *   - 记录：已审批活动按开始时间排序，每条40字节（时间、ID、人数、三个字符串编号）；
+ *   - 字符串表：编号 -> 偏移的索引数组（stringCount + 1项，相邻两项之差即长度），
+ *     之后是UTF-16字符数据，相同的发起人和分类只存一份。
+ * open()只做文件映射和头部校验，读取时直接指向映射内存，字符串用QString::fromRawData
+ * 包装，不解析也不复制（返回的字符串引用映射内存，close()之后还要用的需自行复制）。
+ * 导出使用QSaveFile整体替换，已映射旧文件的进程不受影响。
+ */
+class KioskSnapshot
+{
+public:
+    static constexpr quint32 Magic = 0x534B4143;   // "CAKS"
+    static constexpr quint16 Version = 1;
+
+    KioskSnapshot() = default;
+    ~KioskSnapshot();
+
+    KioskSnapshot(const KioskSnapshot&) = delete;
+    KioskSnapshot& operator=(const KioskSnapshot&) = delete;
+
+    // 从当前数据库导出已审批活动，返回导出的活动数，失败返回-1
+    static int exportApproved(const QString& fileName, QString& error);
+
+    bool open(const QString& fileName, QString& error);
+    void close();
+    bool isOpen() const { return m_records != nullptr; }
+
+    int size() const { return m_recordCount; }
+    qint64 generatedAt() const;
+
+    // 按记录下标读取（记录按开始时间升序）
+    int id(int row) const { return record(row).id; }
+    qint64 startTime(int row) const { return record(row).startTime; }
+    qint64 endTime(int row) const { return record(row).endTime; }
+    int maxParticipants(int row) const { return record(row).maxParticipants; }
+    int currentParticipants(int row) const { return record(row).currentParticipants; }
+    QString title(int row) const { return string(record(row).title); }
+    QString organizer(int row) const { return string(record(row).organizer); }
+    QString category(int row) const { return string(record(row).category); }
+
+    // 文件内的定长结构（布局即文件格式，修改需提升Version）
+    struct Header
+    {
+        quint32 magic;
+        quint16 version;
+        quint16 recordSize;
+        quint32 recordCount;
+        quint32 stringCount;
+        quint64 recordsOffset;
+        quint64 stringIndexOffset;
+        quint64 stringDataOffset;
+        quint64 fileSize;
+        qint64 generatedAt;     // 导出时间（秒级时间戳）
+    };
+
+    struct Record
+    {
+        qint64 startTime;       // 秒级时间戳
+        qint64 endTime;
+        qint32 id;
+        qint32 maxParticipants;
+        qint32 currentParticipants;
+        quint32 title;          // 字符串编号
+        quint32 organizer;
+        quint32 category;
+    };
+
+private:
+    const Record& record(int row) const { return m_records[row]; }
+    QString string(quint32 index) const;
+
+    QFile m_file;
+    const uchar *m_map = nullptr;
+    const Header *m_header = nullptr;
+    const Record *m_records = nullptr;
+    const quint32 *m_stringIndex = nullptr;
+    const QChar *m_stringData = nullptr;
+    int m_recordCount = 0;
+    quint32 m_stringCount = 0;
+    quint32 m_stringDataSize = 0;       // 字符数
+};
+
+#endif // KIOSKSNAPSHOT_H
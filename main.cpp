@@ -1,18 +1,382 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QTableView>
+#include <QHeaderView>
+#include <QFileSystemWatcher>
+#include <QTemporaryDir>
+#include <QDebug>
 #include "logindialog.h"
 #include "adminwidget.h"
 #include "organizerwidget.h"
 #include "studentwidget.h"
+#include "databasemanager.h"
+#include "csvimporter.h"
+#include "startuptrace.h"
+#include "reportexporter.h"
+#include "benchmarks.h"
+#include "tracereplayer.h"
+#include "backupmanager.h"
+#include "kiosksnapshot.h"
+#include "activitymodel.h"
+#include "selfcheck.h"
+
+// 命令行批量导入：--import-users / --import-activities <文件> [--dry-run] [--chunk-size N]
+static int runCsvImport(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+
+    if (!DatabaseManager::instance().initialize()) {
+        out << "数据库初始化失败\n";
+        return 1;
+    }
+
+    const bool importUsers = parser.isSet("import-users");
+    CsvImporter importer(importUsers ? CsvImporter::Target::Users : CsvImporter::Target::Activities,
+                         parser.value(importUsers ? "import-users" : "import-activities"));
+    importer.setDryRun(parser.isSet("dry-run"));
+    if (parser.isSet("chunk-size")) {
+        importer.setChunkSize(parser.value("chunk-size").toInt());
+    }
+
+    CsvImportResult result = importer.run();
+    for (const CsvImportError& error : result.errors) {
+        out << "第" << error.line << "行: " << error.message << "\n";
+    }
+    out << (result.dryRun ? "[试运行] " : "")
+        << "共" << result.totalRows << "行，成功" << result.importedRows
+        << "行，失败" << result.failedRows << "行，耗时" << result.elapsedMs << "ms，"
+        << qRound(result.rowsPerSecond) << "行/秒\n";
+
+    return result.failedRows == 0 && result.errors.isEmpty() ? 0 : 1;
+}
+
+// 命令行分区报表导出：--export-reports <目录> [--by-organizer] [--threads N]
+static int runReportExport(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+
+    if (!DatabaseManager::instance().initialize()) {
+        out << "数据库初始化失败\n";
+        return 1;
+    }
+
+    ReportExporter exporter(parser.isSet("by-organizer") ? ReportExporter::Partition::ByOrganizer
+                                                         : ReportExporter::Partition::ByActivity,
+                            parser.value("export-reports"));
+    if (parser.isSet("threads")) {
+        exporter.setMaxThreads(parser.value("threads").toInt());
+    }
+
+    ReportExportResult result = exporter.run();
+    int failed = 0;
+    for (const ReportFileInfo& info : result.files) {
+        if (!info.ok) {
+            out << info.fileName << ": " << info.error << "\n";
+            ++failed;
+        }
+    }
+    out << "导出" << result.files.size() << "个文件，共" << result.totalRows << "行，"
+        << result.threads << "个线程，耗时" << result.elapsedMs << "ms，清单: " << result.manifestPath << "\n";
+
+    return failed == 0 ? 0 : 1;
+}
+
+// 命令行学期切换：--rollover-term <学期>
+static int runTermRollover(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+
+    if (!DatabaseManager::instance().initialize()) {
+        out << "数据库初始化失败\n";
+        return 1;
+    }
+
+    const QString term = parser.value("rollover-term");
+    if (!DatabaseManager::instance().rolloverTerm(term)) {
+        out << "切换学期失败: " << term << "\n";
+        return 1;
+    }
+
+    out << "当前学期: " << DatabaseManager::instance().activeTerm()
+        << "，已有学期: " << DatabaseManager::instance().availableTerms().join(", ") << "\n";
+    return 0;
+}
+
+// 命令行回放操作轨迹：--replay-trace <文件> [--realtime]，在数据库副本上执行
+static int runTraceReplay(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+
+    const QString dbPath = parser.isSet("database") ? parser.value("database") : DatabaseManager::databasePath();
+    TraceReplayer replayer(parser.value("replay-trace"), dbPath);
+    replayer.setRealTime(parser.isSet("realtime"));
+
+    TraceReplayResult result = replayer.run();
+    if (!result.ok) {
+        out << "回放失败: " << result.error << "\n";
+        return 1;
+    }
+
+    out << "回放" << result.totalOps << "次调用，耗时" << result.elapsedMs << "ms（录制时长"
+        << result.traceDurationMs << "ms）\n";
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+               .arg("操作", -28).arg("次数", 8).arg("失败", 6).arg("平均us", 10)
+               .arg("p50", 10).arg("p90", 10).arg("p99", 10).arg("最大", 10);
+    for (const OperationLatency& op : result.operations) {
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                   .arg(op.name, -28).arg(op.count, 8).arg(op.failed, 6).arg(op.meanUs, 10, 'f', 1)
+                   .arg(op.p50Us, 10).arg(op.p90Us, 10).arg(op.p99Us, 10).arg(op.maxUs, 10);
+    }
+    return 0;
+}
+
+// 命令行在线备份：--backup [--backup-dir <目录>] [--backup-keep N]
+static int runBackup(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+
+    if (!DatabaseManager::instance().initialize()) {
+        out << "数据库初始化失败\n";
+        return 1;
+    }
+
+    BackupManager backup(parser.value("backup-dir"));
+    if (parser.isSet("backup-keep")) {
+        backup.setKeepGenerations(parser.value("backup-keep").toInt());
+    }
+
+    BackupResult result = backup.runBackup();
+    if (!result.ok) {
+        out << "备份失败: " << result.error << "\n";
+        return 1;
+    }
+
+    out << "备份到 " << result.directory << "：" << result.files << "个文件，" << result.bytes << "字节，耗时"
+        << result.elapsedMs << "ms，";
+    if (result.directBackup) {
+        out << "在线备份API " << result.steps << "步（重启" << result.restarts << "次），单步最长阻塞"
+            << result.worstStallMs << "ms\n";
+    } else {
+        out << "VACUUM INTO 整体复制（复制期间持有读锁，未分步）\n";
+    }
+    if (!result.removedGenerations.isEmpty()) {
+        out << "已删除旧备份: " << result.removedGenerations.join(", ") << "\n";
+    }
+    return 0;
+}
+
+// 命令行导出自助查询机快照：--export-kiosk <文件>
+static int runKioskExport(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+
+    if (!DatabaseManager::instance().initialize()) {
+        out << "数据库初始化失败\n";
+        return 1;
+    }
+
+    QString error;
+    const int count = KioskSnapshot::exportApproved(parser.value("export-kiosk"), error);
+    if (count < 0) {
+        out << "导出快照失败: " << error << "\n";
+        return 1;
+    }
+
+    out << "已导出" << count << "个已审批活动到 " << parser.value("export-kiosk") << "\n";
+    return 0;
+}
+
+// 自助查询机模式：--kiosk <快照文件>，不初始化数据库，只映射快照并显示只读列表
+static int runKiosk(const QCommandLineParser& parser, QApplication& app)
+{
+    const QString fileName = parser.value("kiosk");
+
+    QTableView *view = new QTableView();
+    ActivityModel *model = new ActivityModel(view);
+    QString error;
+    if (!model->openSnapshot(fileName, error)) {
+        QTextStream(stderr) << "无法打开快照: " << error << "\n";
+        delete view;
+        return 1;
+    }
+
+    view->setAttribute(Qt::WA_DeleteOnClose);
+    view->setWindowTitle("校园活动 - 自助查询");
+    view->setModel(model);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    view->setColumnHidden(ActivityStore::StatusColumn, true);
+    view->setColumnHidden(ActivityStore::AvailabilityColumn, true);
+    view->horizontalHeader()->setStretchLastSection(true);
+    view->verticalHeader()->hide();
+
+    // 重新导出的快照以新文件替换旧文件，替换后路径需要重新加入监视
+    QFileSystemWatcher *watcher = new QFileSystemWatcher({ fileName }, view);
+    QObject::connect(watcher, &QFileSystemWatcher::fileChanged, view, [model, watcher, fileName]() {
+        QString reloadError;
+        if (!model->openSnapshot(fileName, reloadError)) {
+            qDebug() << "Failed to reload kiosk snapshot:" << reloadError;
+        }
+        if (!watcher->files().contains(fileName)) {
+            watcher->addPath(fileName);
+        }
+    });
+
+    view->showMaximized();
+    StartupTrace::mark("kiosk shown");
+    return app.exec();
+}
+
+// 命令行性能基准：--bench <名称> [--database <文件>]
+// 基准会写入大量测试用户、已审批活动和报名，未指定--database时在临时目录的新数据库上运行，不碰正式数据库
+static int runBenchmark(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+
+    QTemporaryDir tempDir;
+    if (!parser.isSet("database")) {
+        if (!tempDir.isValid()) {
+            out << "无法创建临时目录: " << tempDir.errorString() << "\n";
+            return 1;
+        }
+        const QString benchPath = tempDir.filePath("benchmark.db");
+        DatabaseManager::instance().setDatabasePath(benchPath);
+        out << "未指定--database，在临时数据库上运行: " << benchPath << "\n";
+    }
+
+    if (!DatabaseManager::instance().initialize()) {
+        out << "数据库初始化失败\n";
+        return 1;
+    }
+
+    const QString name = parser.value("bench");
+    if (name == "report-export") {
+        return Benchmarks::runReportExport(out);
+    }
+    if (name == "row-mapping") {
+        return Benchmarks::runRowMapping(out);
+    }
+    if (name == "csv-writer") {
+        return Benchmarks::runCsvWriter(out);
+    }
+
+    out << "未知的基准: " << name << "\n";
+    return 1;
+}
+
+// 命令行自检：--self-check <名称>，总是在临时目录的新数据库上运行
+static int runSelfCheck(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        out << "无法创建临时目录: " << tempDir.errorString() << "\n";
+        return 1;
+    }
+    DatabaseManager::instance().setDatabasePath(tempDir.filePath("self_check.db"));
+
+    const QString name = parser.value("self-check");
+    if (name == "term-ids") {
+        return SelfCheck::runTermIds(out);
+    }
+
+    out << "未知的自检: " << name << "\n";
+    return 1;
+}
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::mark("main");
     QApplication app(argc, argv);
+    StartupTrace::mark("application created");
 
     // 设置应用程序信息
     app.setApplicationName("CampusActivityManager");
     app.setApplicationVersion("1.0.0");
     app.setOrganizationName("CampusActivity");
 
+    // 解析命令行参数
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption({ "import-users", "从CSV批量导入用户", "file" });
+    parser.addOption({ "import-activities", "从CSV批量导入活动", "file" });
+    parser.addOption({ "dry-run", "只校验导入文件，不写入数据库" });
+    parser.addOption({ "chunk-size", "导入时每个事务提交的行数", "rows" });
+    parser.addOption({ "export-reports", "按活动（或发起人）拆分导出报名报表到目录", "dir" });
+    parser.addOption({ "by-organizer", "报表按发起人拆分" });
+    parser.addOption({ "threads", "报表导出的并行线程数", "count" });
+    parser.addOption({ "bench", "运行性能基准（report-export、row-mapping、csv-writer）", "name" });
+    parser.addOption({ "self-check", "在临时数据库上运行自检（term-ids）", "name" });
+    parser.addOption({ "database", "使用指定的数据库文件", "file" });
+    parser.addOption({ "term-shards", "按学期分片存储活动和报名数据" });
+    parser.addOption({ "term", "分片模式下的当前学期（默认按日期推算，如2024fall）", "name" });
+    parser.addOption({ "rollover-term", "切换到新学期分片后退出", "name" });
+    parser.addOption({ "record-trace", "把数据库操作录制到轨迹文件", "file" });
+    parser.addOption({ "replay-trace", "在数据库副本上回放轨迹文件并输出各操作延迟分布", "file" });
+    parser.addOption({ "realtime", "按录制时的时间间隔回放（默认尽快回放）" });
+    parser.addOption({ "backup", "在线备份数据库后退出" });
+    parser.addOption({ "backup-dir", "备份目录（默认为数据库所在目录下的backups）", "dir" });
+    parser.addOption({ "backup-keep", "保留的备份代数（默认7）", "count" });
+    parser.addOption({ "backup-interval", "运行期间每隔指定分钟在后台备份一次", "minutes" });
+    parser.addOption({ "export-kiosk", "导出自助查询机使用的只读快照后退出", "file" });
+    parser.addOption({ "kiosk", "自助查询机模式：只读浏览快照中的已审批活动", "file" });
+    parser.process(app);
+
+    if (parser.isSet("database")) {
+        DatabaseManager::instance().setDatabasePath(parser.value("database"));
+    }
+    if (parser.isSet("term-shards") || parser.isSet("term") || parser.isSet("rollover-term")) {
+        DatabaseManager::instance().setShardingEnabled(true);
+        if (parser.isSet("term")) {
+            DatabaseManager::instance().setActiveTerm(parser.value("term"));
+        }
+    }
+
+    if (parser.isSet("kiosk")) {
+        return runKiosk(parser, app);
+    }
+    if (parser.isSet("self-check")) {
+        return runSelfCheck(parser);
+    }
+    if (parser.isSet("replay-trace")) {
+        return runTraceReplay(parser);
+    }
+    if (parser.isSet("rollover-term")) {
+        return runTermRollover(parser);
+    }
+    if (parser.isSet("record-trace") && !DatabaseManager::instance().startRecording(parser.value("record-trace"))) {
+        QTextStream(stderr) << "无法创建轨迹文件: " << parser.value("record-trace") << "\n";
+        return 1;
+    }
+
+    if (parser.isSet("import-users") || parser.isSet("import-activities")) {
+        return runCsvImport(parser);
+    }
+    if (parser.isSet("export-reports")) {
+        return runReportExport(parser);
+    }
+    if (parser.isSet("bench")) {
+        return runBenchmark(parser);
+    }
+    if (parser.isSet("backup")) {
+        return runBackup(parser);
+    }
+    if (parser.isSet("export-kiosk")) {
+        return runKioskExport(parser);
+    }
+
+    // 运行期间的定时备份在后台线程中进行，不占用界面线程的数据库连接
+    if (parser.isSet("backup-interval") && DatabaseManager::instance().initialize()) {
+        BackupManager *backup = new BackupManager(parser.value("backup-dir"), &app);
+        if (parser.isSet("backup-keep")) {
+            backup->setKeepGenerations(parser.value("backup-keep").toInt());
+        }
+        backup->startSchedule(parser.value("backup-interval").toInt());
+    }
+
     // 创建登录对话框
     LoginDialog *loginDialog = new LoginDialog();
 
@@ -50,10 +414,13 @@ int main(int argc, char *argv[])
                          if (mainWidget) {
                              loginDialog->hide();  // 隐藏登录窗口
                              mainWidget->show();
+                             // 各主界面在构造时已填充活动表，此阶段应晚于"first table rows"
+                             StartupTrace::mark("main window shown");
                          }
                      });
 
     loginDialog->show();
+    StartupTrace::mark("login dialog shown");
 
     return app.exec();
 }
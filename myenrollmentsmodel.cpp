@@ -0,0 +1,119 @@
+//【阶段27：2024-07-03】我的报名模型实现
+
+#include "myenrollmentsmodel.h"
+#include "rowtypes.h"
+#include <QColor>
+
+MyEnrollmentsModel::MyEnrollmentsModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_userId(-1)
+{
+    connect(&DatabaseManager::instance(), &DatabaseManager::enrollmentsChanged,
+            this, &MyEnrollmentsModel::onEnrollmentsChanged);
+}
+
+int MyEnrollmentsModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int MyEnrollmentsModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant MyEnrollmentsModel::data(const QModelIndex& item, int role) const
+{
+    if (!item.isValid() || item.row() >= m_rows.size()) {
+        return QVariant();
+    }
+
+    const Row& row = m_rows.at(item.row());
+
+    if (role == Qt::DisplayRole) {
+        switch (item.column()) {
+        case TitleColumn: return row.title;
+        case StateColumn: return row.waitlisted ? "候补中" : "已报名";
+        case PositionColumn:
+            if (!row.waitlisted || row.waitlist.position <= 0) {
+                return QVariant();
+            }
+            return QString("第%1位/共%2人").arg(row.waitlist.position).arg(row.waitlist.queueLength);
+        case RateColumn:
+            if (!row.waitlisted) {
+                return QVariant();
+            }
+            return row.waitlist.promotionsPerDay > 0.0
+                ? QString("%1人/天").arg(row.waitlist.promotionsPerDay, 0, 'f', 1) : QString("暂无记录");
+        case EtaColumn:
+            if (!row.waitlisted) {
+                return QVariant();
+            }
+            return row.waitlist.estimatedPromotion.isEmpty() ? QString("无法估计") : row.waitlist.estimatedPromotion;
+        default: return QVariant();
+        }
+    }
+
+    // 预计转正时间晚于活动开始的候补以颜色提示
+    if (role == Qt::ForegroundRole && row.waitlisted && item.column() == EtaColumn
+        && !row.waitlist.estimatedPromotion.isEmpty() && row.waitlist.estimatedPromotion > row.waitlist.startTime) {
+        return QColor(Qt::darkYellow);
+    }
+
+    return QVariant();
+}
+
+QVariant MyEnrollmentsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        switch (section) {
+        case TitleColumn: return "活动名称";
+        case StateColumn: return "状态";
+        case PositionColumn: return "候补名次";
+        case RateColumn: return "历史转正速度";
+        case EtaColumn: return "预计转正时间";
+        default: return QVariant();
+        }
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+void MyEnrollmentsModel::refresh(int userId)
+{
+    DatabaseManager& db = DatabaseManager::instance();
+
+    beginResetModel();
+    m_userId = userId;
+    m_rows.clear();
+
+    QSqlQuery query = db.getEnrollments(-1, userId);
+    for (const EnrollmentListRow& enrollment : fetchRows<EnrollmentListRow>(query)) {
+        Row row;
+        row.activityId = enrollment.activityId;
+        row.title = enrollment.activityTitle;
+        m_rows.append(row);
+    }
+
+    for (const WaitlistStatus& status : db.getWaitlistStatuses(userId)) {
+        Row row;
+        row.activityId = status.activityId;
+        row.title = status.title;
+        row.waitlisted = true;
+        row.waitlist = status;
+        m_rows.append(row);
+    }
+
+    endResetModel();
+}
+
+int MyEnrollmentsModel::getActivityId(int row) const
+{
+    return row >= 0 && row < m_rows.size() ? m_rows.at(row).activityId : -1;
+}
+
+void MyEnrollmentsModel::onEnrollmentsChanged()
+{
+    if (m_userId > 0) {
+        refresh(m_userId);
+    }
+}
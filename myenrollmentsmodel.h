@@ -0,0 +1,59 @@
+#ifndef MYENROLLMENTSMODEL_H
+#define MYENROLLMENTSMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QString>
+#include "databasemanager.h"
+
+//【阶段27：2024-07-03】学生“我的报名”表格模型：已报名活动和候补名次、转正估计
+
+/**
+ * @brief 我的报名模型
+ * 先列出已报名的活动，再列出候补中的活动及其名次（第n位/共m人）、历史转正速度和预计转正时间。
+ * 名次来自DatabaseManager的候补名次索引，刷新时每个候补活动只需一次O(log n)查询。
+ */
+class MyEnrollmentsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        TitleColumn = 0,
+        StateColumn,
+        PositionColumn,
+        RateColumn,
+        EtaColumn,
+        ColumnCount
+    };
+
+    explicit MyEnrollmentsModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& item, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void refresh(int userId);
+
+    // 行对应的活动ID
+    int getActivityId(int row) const;
+
+private slots:
+    // 报名或候补变化时重新查询（行数很少）
+    void onEnrollmentsChanged();
+
+private:
+    struct Row
+    {
+        int activityId = -1;
+        QString title;
+        bool waitlisted = false;
+        WaitlistStatus waitlist;
+    };
+
+    QVector<Row> m_rows;
+    int m_userId;
+};
+
+#endif // MYENROLLMENTSMODEL_H
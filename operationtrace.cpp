@@ -0,0 +1,158 @@
+//【阶段20：2024-06-17】操作轨迹的二进制读写
+
+#include "operationtrace.h"
+#include <QDebug>
+
+namespace {
+
+const quint32 kTraceMagic = 0x43415452;    // "CATR"
+const quint16 kTraceVersion = 1;
+
+}
+
+const char *traceOpName(TraceOp op)
+{
+    switch (op) {
+    case TraceOp::GetActivities: return "getActivities";
+    case TraceOp::GetActivityById: return "getActivityById";
+    case TraceOp::GetActivityDetail: return "getActivityDetail";
+    case TraceOp::GetStudentListing: return "getStudentActivityListing";
+    case TraceOp::GetEnrollments: return "getEnrollments";
+    case TraceOp::CheckTimeConflict: return "checkTimeConflict";
+    case TraceOp::CreateActivity: return "createActivity";
+    case TraceOp::UpdateActivityStatus: return "updateActivityStatus";
+    case TraceOp::Enroll: return "enrollActivity";
+    case TraceOp::Cancel: return "cancelEnrollment";
+    case TraceOp::AddToWaitlist: return "addToWaitlist";
+    case TraceOp::ProcessWaitlist: return "processWaitlist";
+    case TraceOp::Approve: return "approveActivity";
+    case TraceOp::Reject: return "rejectActivity";
+    case TraceOp::ApproveBatch: return "approveActivities";
+    case TraceOp::RejectBatch: return "rejectActivities";
+    case TraceOp::ArchiveCompleted: return "archiveCompletedData";
+    case TraceOp::CreateSeries: return "createActivitySeries";
+    case TraceOp::GetOccurrences: return "getOccurrences";
+    case TraceOp::EnrollOccurrence: return "enrollOccurrence";
+    case TraceOp::CancelOccurrence: return "cancelOccurrenceEnrollment";
+    case TraceOp::GetActivitiesInRange: return "getActivitiesInRange";
+    case TraceOp::GetWaitlistStatus: return "getWaitlistStatus";
+    case TraceOp::GetWaitlistStatuses: return "getWaitlistStatuses";
+    case TraceOp::GetActivityPage: return "getActivityPage";
+    case TraceOp::UpdateSeriesStatus: return "updateSeriesStatus";
+    case TraceOp::CancelSeriesOccurrence: return "cancelOccurrence";
+    case TraceOp::RescheduleOccurrence: return "rescheduleOccurrence";
+    case TraceOp::SetOccurrenceCapacity: return "setOccurrenceCapacity";
+    }
+    return "unknown";
+}
+
+OperationRecorder::~OperationRecorder()
+{
+    stop();
+}
+
+bool OperationRecorder::start(const QString& fileName)
+{
+    stop();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Failed to open trace file:" << m_file.errorString();
+        return false;
+    }
+
+    m_out.setDevice(&m_file);
+    m_out.setVersion(QDataStream::Qt_6_0);
+    m_out << kTraceMagic << kTraceVersion;
+
+    m_lastUs = 0;
+    m_clock.start();
+    return true;
+}
+
+void OperationRecorder::stop()
+{
+    if (m_file.isOpen()) {
+        m_out.setDevice(nullptr);
+        m_file.close();
+    }
+}
+
+void OperationRecorder::record(TraceOp op, int userId, int activityId,
+                               const QList<int>& ids, const QStringList& text)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    // 存时间差而不是绝对时间，两次调用间隔超过约71分钟时截断
+    const qint64 nowUs = m_clock.nsecsElapsed() / 1000;
+    const quint32 deltaUs = quint32(qMin<qint64>(nowUs - m_lastUs, 0xFFFFFFFF));
+    m_lastUs = nowUs;
+
+    m_out << quint8(op) << deltaUs << qint32(userId) << qint32(activityId);
+    m_out << quint32(ids.size());
+    for (int id : ids) {
+        m_out << qint32(id);
+    }
+    m_out << quint8(text.size());
+    for (const QString& value : text) {
+        m_out << value;
+    }
+}
+
+bool OperationRecorder::load(const QString& fileName, QList<TraceRecord>& records, QString& error)
+{
+    records.clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != kTraceMagic || version != kTraceVersion) {
+        error = "不是有效的操作轨迹文件";
+        return false;
+    }
+
+    qint64 timestampUs = 0;
+    while (!in.atEnd()) {
+        TraceRecord record;
+        quint8 op = 0;
+        quint32 deltaUs = 0;
+        quint32 idCount = 0;
+        in >> op >> deltaUs >> record.userId >> record.activityId >> idCount;
+        for (quint32 i = 0; i < idCount && in.status() == QDataStream::Ok; ++i) {
+            qint32 id = 0;
+            in >> id;
+            record.ids.append(id);
+        }
+        quint8 textCount = 0;
+        in >> textCount;
+        for (quint8 i = 0; i < textCount && in.status() == QDataStream::Ok; ++i) {
+            QString value;
+            in >> value;
+            record.text.append(value);
+        }
+
+        // 录制进程被强制结束时最后一条记录可能不完整，丢弃即可
+        if (in.status() != QDataStream::Ok) {
+            qDebug() << "Trace truncated after" << records.size() << "records";
+            break;
+        }
+
+        timestampUs += deltaUs;
+        record.timestampUs = timestampUs;
+        record.op = TraceOp(op);
+        records.append(record);
+    }
+
+    return true;
+}
@@ -0,0 +1,101 @@
+#ifndef OPERATIONTRACE_H
+#define OPERATIONTRACE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+
+//【阶段20：2024-06-17】记录DatabaseManager公开调用，生成可回放的二进制操作轨迹
+
+// 被记录的操作（数值写入轨迹文件，只能追加不能调整）
+enum class TraceOp : quint8 {
+    GetActivities = 1,
+    GetActivityById,
+    GetActivityDetail,
+    GetStudentListing,
+    GetEnrollments,
+    CheckTimeConflict,
+    CreateActivity,
+    UpdateActivityStatus,
+    Enroll,
+    Cancel,
+    AddToWaitlist,
+    ProcessWaitlist,
+    Approve,
+    Reject,
+    ApproveBatch,
+    RejectBatch,
+    ArchiveCompleted,
+    CreateSeries,
+    GetOccurrences,
+    EnrollOccurrence,
+    CancelOccurrence,
+    GetActivitiesInRange,
+    GetWaitlistStatus,
+    GetWaitlistStatuses,
+    GetActivityPage,
+    UpdateSeriesStatus,
+    CancelSeriesOccurrence,
+    RescheduleOccurrence,
+    SetOccurrenceCapacity
+};
+
+// 一次调用：用户和活动ID放在固定字段，其余整数参数放在ids，字符串参数按声明顺序放在text
+struct TraceRecord
+{
+    qint64 timestampUs = 0;     // 相对录制开始的微秒数
+    TraceOp op = TraceOp::GetActivities;
+    qint32 userId = -1;         // 学生/管理员ID
+    qint32 activityId = -1;     // 周期活动相关的调用中为系列ID
+    QList<qint32> ids;          // 批量操作或增量查询的活动ID，或其他整数参数
+    QStringList text;
+};
+
+// 操作名称，用于报告
+const char *traceOpName(TraceOp op);
+
+/**
+ * @brief 操作轨迹录制器
+ * 文件格式：魔数+版本头，之后每条记录依次为
+ * 操作码、与上一条的时间差（微秒）、userId、activityId、ID列表、字符串列表（QDataStream编码）。
+ */
+class OperationRecorder
+{
+public:
+    ~OperationRecorder();
+
+    bool start(const QString& fileName);
+    void stop();
+    bool isActive() const { return m_file.isOpen(); }
+
+    // 以当前时间为时间戳追加一条记录
+    void record(TraceOp op, int userId, int activityId,
+                const QList<int>& ids = QList<int>(), const QStringList& text = QStringList());
+
+    // 读取整个轨迹文件，失败时error给出原因
+    static bool load(const QString& fileName, QList<TraceRecord>& records, QString& error);
+
+private:
+    QFile m_file;
+    QDataStream m_out;
+    QElapsedTimer m_clock;
+    qint64 m_lastUs = 0;
+};
+
+// 只记录最外层调用：公开接口之间互相调用（如取消报名后处理候补）时不重复记录
+class TraceScope
+{
+public:
+    explicit TraceScope(int& depth) : m_depth(depth) { ++m_depth; }
+    ~TraceScope() { --m_depth; }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    int& m_depth;
+};
+
+#endif // OPERATIONTRACE_H
@@ -0,0 +1,47 @@
+//【阶段24：2024-06-26】重复规则的场次计算
+
+#include "recurrence.h"
+#include <cmath>
+
+bool RecurrenceRule::isValid() const
+{
+    return firstStart.isValid() && firstEnd.isValid() && firstEnd > firstStart
+        && intervalDays > 0 && occurrenceCount > 0;
+}
+
+bool RecurrenceRule::occurrenceOverlaps(int index, const QDateTime& from, const QDateTime& to) const
+{
+    return occurrenceStart(index) < to && occurrenceEnd(index) > from;
+}
+
+bool RecurrenceRule::indexRange(const QDateTime& from, const QDateTime& to, int& first, int& last) const
+{
+    if (!isValid() || !(from < to)) {
+        return false;
+    }
+
+    // 近似计算：夏令时切换最多让某场偏移一小时，由下面的校正处理
+    const double period = double(intervalDays) * 86400.0;
+    const qint64 duration = firstStart.secsTo(firstEnd);
+    const qint64 lowOffset = firstStart.secsTo(from) - duration;
+    const qint64 highOffset = firstStart.secsTo(to);
+
+    const int lastIndex = occurrenceCount - 1;
+    first = qBound(0, int(std::ceil(lowOffset / period)), lastIndex);
+    last = qBound(0, int(std::floor(highOffset / period)), lastIndex);
+
+    while (first > 0 && occurrenceOverlaps(first - 1, from, to)) {
+        --first;
+    }
+    while (first <= last && !occurrenceOverlaps(first, from, to)) {
+        ++first;
+    }
+    while (last < lastIndex && occurrenceOverlaps(last + 1, from, to)) {
+        ++last;
+    }
+    while (last >= first && !occurrenceOverlaps(last, from, to)) {
+        --last;
+    }
+
+    return first <= last;
+}
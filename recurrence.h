@@ -0,0 +1,33 @@
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+
+#include <QDateTime>
+
+//【阶段24：2024-06-26】周期活动的重复规则：按规则直接计算场次，不逐场物化
+
+/**
+ * @brief 重复规则
+ * 第index场（从0开始）的时间为首场时间加 index * intervalDays 天（保持当地钟点），
+ * 共occurrenceCount场。例外（取消、改期、单场容量）由DatabaseManager另行记录。
+ */
+struct RecurrenceRule
+{
+    QDateTime firstStart;
+    QDateTime firstEnd;
+    int intervalDays = 7;
+    int occurrenceCount = 1;
+
+    bool isValid() const;
+
+    QDateTime occurrenceStart(int index) const { return firstStart.addDays(qint64(index) * intervalDays); }
+    QDateTime occurrenceEnd(int index) const { return firstEnd.addDays(qint64(index) * intervalDays); }
+
+    // 第index场是否与 [from, to) 有交集
+    bool occurrenceOverlaps(int index, const QDateTime& from, const QDateTime& to) const;
+
+    // 与 [from, to) 有交集的场次下标范围 [first, last]，没有则返回false；
+    // 先按周期算出近似范围，再逐端校正，只检查边界附近的几场
+    bool indexRange(const QDateTime& from, const QDateTime& to, int& first, int& last) const;
+};
+
+#endif // RECURRENCE_H
@@ -0,0 +1,205 @@
+//【阶段18：2024-06-12】使用QtConcurrent在线程池中并行生成分区报表
+
+#include "reportexporter.h"
+#include "databasemanager.h"
+#include "rowtypes.h"
+#include "csvwriter.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QThread>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QtConcurrent>
+#include <QDebug>
+
+namespace {
+
+// 每个任务独立连接的名称序号
+QAtomicInt g_connectionSerial;
+
+// 文件名中不允许出现的字符替换为下划线
+QString safeFileName(const QString& name)
+{
+    QString result = name;
+    static const QString invalid = "\\/:*?\"<>| \t\r\n";
+    for (QChar& ch : result) {
+        if (invalid.contains(ch)) {
+            ch = '_';
+        }
+    }
+    return result;
+}
+
+}
+
+ReportExporter::ReportExporter(Partition partition, const QString& outputDir)
+    : m_partition(partition)
+    , m_outputDir(outputDir)
+    , m_maxThreads(0)
+{
+}
+
+QList<ReportPartition> ReportExporter::loadPartitions(const QString& dbPath) const
+{
+    QList<ReportPartition> partitions;
+
+    // 主线程的连接只用于列出分区
+    QSqlQuery query(DatabaseManager::instance().database());
+    query.setForwardOnly(true);
+    if (m_partition == Partition::ByActivity) {
+        query.exec(DatabaseManager::instance().fanOutSql("SELECT id, title FROM $term.all_activities", "id"));
+    } else {
+        query.exec("SELECT id, username FROM users WHERE role = 'organizer' ORDER BY id");
+    }
+
+    if (!query.isActive()) {
+        qDebug() << "Failed to list report partitions in" << dbPath << ":" << query.lastError().text();
+        return partitions;
+    }
+
+    while (query.next()) {
+        partitions.append({ query.value(0).toInt(), query.value(1).toString() });
+    }
+    return partitions;
+}
+
+ReportFileInfo ReportExporter::exportPartition(Partition partition, const QString& dbPath,
+                                               const QList<TermDatabase>& terms, const QString& sqlTemplate,
+                                               const QString& outputDir, const ReportPartition& part)
+{
+    ReportFileInfo info;
+    info.key = part.key;
+    info.name = part.name;
+    info.fileName = (partition == Partition::ByActivity)
+        ? QString("activity_%1.csv").arg(part.key)
+        : QString("organizer_%1_%2.csv").arg(part.key).arg(safeFileName(part.name));
+
+    const QString connectionName = QString("report_reader_%1").arg(g_connectionSerial.fetchAndAddRelaxed(1));
+    {
+        // 每个工作任务使用自己的只读连接
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(dbPath);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+
+        // 分片模式下按主连接相同的库名和顺序附加各学期分片
+        if (!db.open() || !DatabaseManager::attachTermDatabases(db, terms)) {
+            info.error = db.lastError().text();
+        } else {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+
+            QFile file(QDir(outputDir).filePath(info.fileName));
+            if (!query.exec(sqlTemplate.arg(part.key))) {
+                info.error = query.lastError().text();
+            } else if (!file.open(QIODevice::WriteOnly)) {
+                info.error = file.errorString();
+            } else {
+                CsvWriter writer(&file);
+                writer.writeBom();
+                writer.writeRow({ "活动ID", "活动名称", "发起人", "报名学生", "报名时间", "状态" });
+
+                EnrollmentRow row;
+                while (query.next()) {
+                    readRow(query, row);
+                    writer.writeField(row.activityId);
+                    writer.writeField(row.activityTitle);
+                    writer.writeField(row.organizerName);
+                    writer.writeField(row.username);
+                    writer.writeField(row.enrolledAt);
+                    writer.writeField(row.status);
+                    writer.endRow();
+                    ++info.rows;
+                }
+
+                if (!writer.flush()) {
+                    info.error = file.errorString();
+                } else {
+                    info.bytes = file.size();
+                    info.ok = true;
+                }
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    return info;
+}
+
+bool ReportExporter::writeManifest(const QString& path, const QList<ReportFileInfo>& files)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to write manifest:" << file.errorString();
+        return false;
+    }
+
+    CsvWriter writer(&file);
+    writer.writeRow({ "file", "key", "name", "rows", "bytes", "status" });
+    for (const ReportFileInfo& info : files) {
+        writer.writeField(info.fileName);
+        writer.writeField(info.key);
+        writer.writeField(info.name);
+        writer.writeField(info.rows);
+        writer.writeField(info.bytes);
+        writer.writeField(info.ok ? QString("ok") : info.error);
+        writer.endRow();
+    }
+    return writer.flush();
+}
+
+ReportExportResult ReportExporter::run()
+{
+    ReportExportResult result;
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlDatabase mainDb = DatabaseManager::instance().database();
+    if (!mainDb.isOpen()) {
+        qDebug() << "Database is not open";
+        return result;
+    }
+    const QString dbPath = mainDb.databaseName();
+
+    QDir dir(m_outputDir);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qDebug() << "Failed to create report directory:" << m_outputDir;
+        return result;
+    }
+
+    const QList<ReportPartition> partitions = loadPartitions(dbPath);
+
+    QThreadPool pool;
+    result.threads = m_maxThreads > 0 ? m_maxThreads : QThread::idealThreadCount();
+    pool.setMaxThreadCount(result.threads);
+
+    // 分片列表和跨学期查询在主线程构造一次，分区键为整数，由工作任务直接填入
+    const QList<TermDatabase> terms = DatabaseManager::instance().termDatabases();
+    const QString sqlTemplate = DatabaseManager::instance().fanOutSql(
+        selectSql<EnrollmentRow>(QString("WHERE e.status = 'enrolled' AND %1 = %2")
+            .arg(m_partition == Partition::ByActivity ? "e.activity_id" : "a.organizer_id", "%1")),
+        "activity_id, enrolled_at");
+
+    const Partition partition = m_partition;
+    const QString outputDir = dir.absolutePath();
+    result.files = QtConcurrent::blockingMapped(&pool, partitions,
+        [partition, dbPath, terms, sqlTemplate, outputDir](const ReportPartition& part) {
+            return exportPartition(partition, dbPath, terms, sqlTemplate, outputDir, part);
+        });
+
+    for (const ReportFileInfo& info : result.files) {
+        result.totalRows += info.rows;
+    }
+
+    result.manifestPath = dir.filePath("manifest.csv");
+    writeManifest(result.manifestPath, result.files);
+
+    result.elapsedMs = timer.elapsed();
+    qDebug() << "Exported" << result.files.size() << "report files (" << result.totalRows << "rows ) to"
+             << outputDir << "with" << result.threads << "threads in" << result.elapsedMs << "ms";
+    return result;
+}
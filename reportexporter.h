@@ -0,0 +1,75 @@
+#ifndef REPORTEXPORTER_H
+#define REPORTEXPORTER_H
+
+#include <QString>
+#include <QList>
+
+struct TermDatabase;
+
+//【阶段18：2024-06-12】按活动/发起人拆分的并行报表导出
+
+// 一个导出分区（一个活动或一个发起人）
+struct ReportPartition
+{
+    int key = -1;        // 活动ID或发起人用户ID
+    QString name;        // 活动名称或发起人用户名
+};
+
+// 单个报表文件的导出结果
+struct ReportFileInfo
+{
+    QString fileName;
+    int key = -1;
+    QString name;
+    int rows = 0;
+    qint64 bytes = 0;
+    bool ok = false;
+    QString error;
+};
+
+struct ReportExportResult
+{
+    QList<ReportFileInfo> files;
+    QString manifestPath;
+    int threads = 0;
+    int totalRows = 0;
+    qint64 elapsedMs = 0;
+};
+
+/**
+ * @brief 分区报表导出类
+ * 每个分区生成一个CSV文件，在线程池中并行生成；
+ * 每个任务使用独立的只读数据库连接（SQLite连接不能跨线程共享），
+ * 最后写入manifest.csv列出所有文件。
+ */
+class ReportExporter
+{
+public:
+    enum class Partition {
+        ByActivity,
+        ByOrganizer
+    };
+
+    ReportExporter(Partition partition, const QString& outputDir);
+
+    // 并行线程数，<= 0 使用QThread::idealThreadCount()
+    void setMaxThreads(int threads) { m_maxThreads = threads; }
+
+    // 在调用线程中阻塞执行
+    ReportExportResult run();
+
+private:
+    QList<ReportPartition> loadPartitions(const QString& dbPath) const;
+
+    // sqlTemplate中的%1为分区键
+    static ReportFileInfo exportPartition(Partition partition, const QString& dbPath,
+                                          const QList<TermDatabase>& terms, const QString& sqlTemplate,
+                                          const QString& outputDir, const ReportPartition& part);
+    static bool writeManifest(const QString& path, const QList<ReportFileInfo>& files);
+
+    Partition m_partition;
+    QString m_outputDir;
+    int m_maxThreads;
+};
+
+#endif // REPORTEXPORTER_H
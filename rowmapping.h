@@ -0,0 +1,107 @@
+#ifndef ROWMAPPING_H
+#define ROWMAPPING_H
+
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+//【阶段19：2024-06-14】编译期列映射：SELECT列清单与结构体字段绑定在一处定义
+
+/**
+ * @brief 行映射模板层
+ * 为结构体特化 RowMapping<Row>，在同一处声明 SQL 列表达式和对应字段：
+ *
+ *   template<> struct RowMapping<FooRow> {
+ *       static constexpr const char *from = "foo f";
+ *       static constexpr auto columns = std::make_tuple(
+ *           column("f.id", &FooRow::id),
+ *           column("f.name", &FooRow::name));
+ *   };
+ *
+ * selectSql<FooRow>() 由列清单生成 SELECT 语句，fetchRows<FooRow>() 按编译期确定的列下标
+ * 直接读入类型化字段，SELECT 与读取位置不会再因修改其中一处而错位。
+ */
+
+template<typename Row, typename T>
+struct ColumnBinding
+{
+    const char *expression;
+    T Row::*member;
+};
+
+template<typename Row, typename T>
+constexpr ColumnBinding<Row, T> column(const char *expression, T Row::*member)
+{
+    return { expression, member };
+}
+
+template<typename Row>
+struct RowMapping;
+
+namespace RowMappingDetail
+{
+    // 按字段类型从当前行读取，只做一次类型转换
+    inline void read(const QSqlQuery& query, int index, int& out) { out = query.value(index).toInt(); }
+    inline void read(const QSqlQuery& query, int index, qint64& out) { out = query.value(index).toLongLong(); }
+    inline void read(const QSqlQuery& query, int index, double& out) { out = query.value(index).toDouble(); }
+    inline void read(const QSqlQuery& query, int index, bool& out) { out = query.value(index).toBool(); }
+    inline void read(const QSqlQuery& query, int index, QString& out) { out = query.value(index).toString(); }
+
+    template<typename Row, typename Tuple, std::size_t... I>
+    void readRow(const QSqlQuery& query, Row& row, const Tuple& columns, std::index_sequence<I...>)
+    {
+        (read(query, int(I), row.*(std::get<I>(columns).member)), ...);
+    }
+
+    template<typename Tuple, std::size_t... I>
+    QStringList expressions(const Tuple& columns, std::index_sequence<I...>)
+    {
+        return QStringList{ QString::fromLatin1(std::get<I>(columns).expression)... };
+    }
+}
+
+// 结构体对应的列数
+template<typename Row>
+constexpr std::size_t columnCount()
+{
+    return std::tuple_size<std::decay_t<decltype(RowMapping<Row>::columns)>>::value;
+}
+
+// 生成 "SELECT <列清单> FROM <from> <tail>"
+template<typename Row>
+QString selectSql(const QString& tail = QString())
+{
+    const QStringList columns = RowMappingDetail::expressions(
+        RowMapping<Row>::columns, std::make_index_sequence<columnCount<Row>()>());
+    QString sql = "SELECT " + columns.join(", ") + " FROM " + QString::fromUtf8(RowMapping<Row>::from);
+    if (!tail.isEmpty()) {
+        sql += ' ' + tail;
+    }
+    return sql;
+}
+
+// 读取查询当前行
+template<typename Row>
+void readRow(const QSqlQuery& query, Row& row)
+{
+    RowMappingDetail::readRow(query, row, RowMapping<Row>::columns,
+                              std::make_index_sequence<columnCount<Row>()>());
+}
+
+// 读取已执行查询的剩余全部行，结果连续存放
+template<typename Row>
+std::vector<Row> fetchRows(QSqlQuery& query, std::size_t expectedRows = 0)
+{
+    std::vector<Row> rows;
+    rows.reserve(expectedRows);
+    while (query.next()) {
+        rows.emplace_back();
+        readRow(query, rows.back());
+    }
+    return rows;
+}
+
+#endif // ROWMAPPING_H
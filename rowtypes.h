@@ -0,0 +1,323 @@
+#ifndef ROWTYPES_H
+#define ROWTYPES_H
+
+#include "rowmapping.h"
+
+//【阶段19：2024-06-14】常用查询的类型化行结构及其列映射
+
+// 活动列表行（getActivities的结果）：只包含表格显示的列，不取description和created_at
+struct ActivityListRow
+{
+    int id = -1;
+    QString title;
+    QString organizerName;
+    QString startTime;
+    QString endTime;
+    int maxParticipants = 0;
+    int currentParticipants = 0;
+    QString status;
+    QString category;
+};
+
+template<>
+struct RowMapping<ActivityListRow>
+{
+    static constexpr const char *from = "activities a JOIN users u ON a.organizer_id = u.id";
+    static constexpr auto columns = std::make_tuple(
+        column("a.id", &ActivityListRow::id),
+        column("a.title", &ActivityListRow::title),
+        column("u.username", &ActivityListRow::organizerName),
+        column("a.start_time", &ActivityListRow::startTime),
+        column("a.end_time", &ActivityListRow::endTime),
+        column("a.max_participants", &ActivityListRow::maxParticipants),
+        column("a.current_participants", &ActivityListRow::currentParticipants),
+        column("a.status", &ActivityListRow::status),
+        column("a.category", &ActivityListRow::category));
+};
+
+// 活动详情行（getActivityById的结果，只为选中的活动查询）
+struct ActivityRow
+{
+    int id = -1;
+    QString title;
+    QString description;
+    QString organizerName;
+    QString startTime;
+    QString endTime;
+    int maxParticipants = 0;
+    int currentParticipants = 0;
+    QString status;
+    QString category;
+    QString createdAt;
+};
+
+template<>
+struct RowMapping<ActivityRow>
+{
+    static constexpr const char *from = "activities a JOIN users u ON a.organizer_id = u.id";
+    static constexpr auto columns = std::make_tuple(
+        column("a.id", &ActivityRow::id),
+        column("a.title", &ActivityRow::title),
+        column("a.description", &ActivityRow::description),
+        column("u.username", &ActivityRow::organizerName),
+        column("a.start_time", &ActivityRow::startTime),
+        column("a.end_time", &ActivityRow::endTime),
+        column("a.max_participants", &ActivityRow::maxParticipants),
+        column("a.current_participants", &ActivityRow::currentParticipants),
+        column("a.status", &ActivityRow::status),
+        column("a.category", &ActivityRow::category),
+        column("a.created_at", &ActivityRow::createdAt));
+};
+
+// 时间轴上的活动块：只取绘制和提示需要的列
+struct TimelineRow
+{
+    int id = -1;
+    QString title;
+    QString startTime;
+    QString endTime;
+    int maxParticipants = 0;
+    int currentParticipants = 0;
+    QString status;
+};
+
+template<>
+struct RowMapping<TimelineRow>
+{
+    static constexpr const char *from = "activities a";
+    static constexpr auto columns = std::make_tuple(
+        column("a.id", &TimelineRow::id),
+        column("a.title", &TimelineRow::title),
+        column("a.start_time", &TimelineRow::startTime),
+        column("a.end_time", &TimelineRow::endTime),
+        column("a.max_participants", &TimelineRow::maxParticipants),
+        column("a.current_participants", &TimelineRow::currentParticipants),
+        column("a.status", &TimelineRow::status));
+};
+
+// 学生活动列表行：已审批活动及本人的报名/候补标记（两个EXISTS子查询各绑定一次学生ID）
+struct StudentListingRow
+{
+    int id = -1;
+    QString title;
+    QString organizerName;
+    QString startTime;
+    QString endTime;
+    int maxParticipants = 0;
+    int currentParticipants = 0;
+    QString status;
+    QString category;
+    bool enrolled = false;
+    bool waitlisted = false;
+};
+
+template<>
+struct RowMapping<StudentListingRow>
+{
+    static constexpr const char *from = "activities a JOIN users u ON a.organizer_id = u.id";
+    static constexpr auto columns = std::make_tuple(
+        column("a.id", &StudentListingRow::id),
+        column("a.title", &StudentListingRow::title),
+        column("u.username", &StudentListingRow::organizerName),
+        column("a.start_time", &StudentListingRow::startTime),
+        column("a.end_time", &StudentListingRow::endTime),
+        column("a.max_participants", &StudentListingRow::maxParticipants),
+        column("a.current_participants", &StudentListingRow::currentParticipants),
+        column("a.status", &StudentListingRow::status),
+        column("a.category", &StudentListingRow::category),
+        column(R"(EXISTS(SELECT 1 FROM enrollments e
+                  WHERE e.user_id = ? AND e.activity_id = a.id AND e.status = 'enrolled'))",
+               &StudentListingRow::enrolled),
+        column("EXISTS(SELECT 1 FROM waitlist w WHERE w.user_id = ? AND w.activity_id = a.id)",
+               &StudentListingRow::waitlisted));
+};
+
+// 报名前检查所需的活动状态和容量
+struct ActivityCapacityRow
+{
+    QString status;
+    int maxParticipants = 0;
+    int currentParticipants = 0;
+    QString startTime;
+    QString endTime;
+};
+
+template<>
+struct RowMapping<ActivityCapacityRow>
+{
+    static constexpr const char *from = "activities";
+    static constexpr auto columns = std::make_tuple(
+        column("status", &ActivityCapacityRow::status),
+        column("max_participants", &ActivityCapacityRow::maxParticipants),
+        column("current_participants", &ActivityCapacityRow::currentParticipants),
+        column("start_time", &ActivityCapacityRow::startTime),
+        column("end_time", &ActivityCapacityRow::endTime));
+};
+
+// 周期活动系列（规则部分），场次由RecurrenceRule按需计算
+struct ActivitySeriesRow
+{
+    int id = -1;
+    QString title;
+    QString organizerName;
+    QString firstStart;
+    QString firstEnd;
+    int intervalDays = 7;
+    int occurrenceCount = 1;
+    int maxParticipants = 0;
+    QString status;
+    QString category;
+};
+
+template<>
+struct RowMapping<ActivitySeriesRow>
+{
+    static constexpr const char *from = "activity_series s JOIN users u ON s.organizer_id = u.id";
+    static constexpr auto columns = std::make_tuple(
+        column("s.id", &ActivitySeriesRow::id),
+        column("s.title", &ActivitySeriesRow::title),
+        column("u.username", &ActivitySeriesRow::organizerName),
+        column("s.first_start", &ActivitySeriesRow::firstStart),
+        column("s.first_end", &ActivitySeriesRow::firstEnd),
+        column("s.interval_days", &ActivitySeriesRow::intervalDays),
+        column("s.occurrence_count", &ActivitySeriesRow::occurrenceCount),
+        column("s.max_participants", &ActivitySeriesRow::maxParticipants),
+        column("s.status", &ActivitySeriesRow::status),
+        column("s.category", &ActivitySeriesRow::category));
+};
+
+// 周期活动的场次记录：只有取消、改期、单独设置容量或有人报名的场次才有
+struct SeriesOccurrenceRow
+{
+    int seriesId = -1;
+    int occurrenceIndex = 0;
+    bool cancelled = false;
+    QString startTime;              // 改期后的时间，未改期为空
+    QString endTime;
+    int maxParticipants = -1;       // 单场容量，未单独设置为-1
+    int currentParticipants = 0;
+};
+
+template<>
+struct RowMapping<SeriesOccurrenceRow>
+{
+    static constexpr const char *from = "series_occurrences o";
+    static constexpr auto columns = std::make_tuple(
+        column("o.series_id", &SeriesOccurrenceRow::seriesId),
+        column("o.occurrence_index", &SeriesOccurrenceRow::occurrenceIndex),
+        column("o.cancelled", &SeriesOccurrenceRow::cancelled),
+        column("COALESCE(o.start_time, '')", &SeriesOccurrenceRow::startTime),
+        column("COALESCE(o.end_time, '')", &SeriesOccurrenceRow::endTime),
+        column("COALESCE(o.max_participants, -1)", &SeriesOccurrenceRow::maxParticipants),
+        column("o.current_participants", &SeriesOccurrenceRow::currentParticipants));
+};
+
+// 报名报表行（跨热表和归档表）
+struct EnrollmentRow
+{
+    int activityId = -1;
+    QString activityTitle;
+    QString organizerName;
+    QString username;
+    QString enrolledAt;
+    QString status;
+};
+
+template<>
+struct RowMapping<EnrollmentRow>
+{
+    // $term. 由DatabaseManager::fanOutSql替换为各学期库名
+    static constexpr const char *from = R"($term.all_enrollments e
+        JOIN users u ON e.user_id = u.id
+        JOIN $term.all_activities a ON e.activity_id = a.id
+        JOIN users organizer ON a.organizer_id = organizer.id)";
+    static constexpr auto columns = std::make_tuple(
+        column("e.activity_id", &EnrollmentRow::activityId),
+        column("a.title", &EnrollmentRow::activityTitle),
+        column("organizer.username", &EnrollmentRow::organizerName),
+        column("u.username", &EnrollmentRow::username),
+        column("e.enrolled_at", &EnrollmentRow::enrolledAt),
+        column("e.status", &EnrollmentRow::status));
+};
+
+// 有效报名列表行（getEnrollments的结果）
+struct EnrollmentListRow
+{
+    int id = -1;
+    int userId = -1;
+    QString username;
+    QString enrolledAt;
+    QString status;
+    QString activityTitle;
+    int activityId = -1;
+};
+
+template<>
+struct RowMapping<EnrollmentListRow>
+{
+    static constexpr const char *from = R"(enrollments e
+        JOIN users u ON e.user_id = u.id
+        JOIN activities a ON e.activity_id = a.id)";
+    static constexpr auto columns = std::make_tuple(
+        column("e.id", &EnrollmentListRow::id),
+        column("e.user_id", &EnrollmentListRow::userId),
+        column("u.username", &EnrollmentListRow::username),
+        column("e.enrolled_at", &EnrollmentListRow::enrolledAt),
+        column("e.status", &EnrollmentListRow::status),
+        column("a.title", &EnrollmentListRow::activityTitle),
+        column("e.activity_id", &EnrollmentListRow::activityId));
+};
+
+// 学生所在的候补队列（活动名称和开始时间）
+struct WaitlistEntryRow
+{
+    int activityId = -1;
+    QString title;
+    QString startTime;
+};
+
+template<>
+struct RowMapping<WaitlistEntryRow>
+{
+    static constexpr const char *from = "waitlist w JOIN activities a ON w.activity_id = a.id";
+    static constexpr auto columns = std::make_tuple(
+        column("w.activity_id", &WaitlistEntryRow::activityId),
+        column("a.title", &WaitlistEntryRow::title),
+        column("a.start_time", &WaitlistEntryRow::startTime));
+};
+
+// 候补队列中的一人及已等待的秒数（按队列顺序读取）
+struct WaitlistQueueRow
+{
+    int userId = -1;
+    qint64 waitedSeconds = 0;
+};
+
+template<>
+struct RowMapping<WaitlistQueueRow>
+{
+    static constexpr const char *from = "waitlist";
+    static constexpr auto columns = std::make_tuple(
+        column("user_id", &WaitlistQueueRow::userId),
+        column("CAST((julianday('now') - julianday(added_at)) * 86400 AS INTEGER)", &WaitlistQueueRow::waitedSeconds));
+};
+
+// 转正记录统计：条数、涉及的活动数、第一次转正至今的天数（没有记录时为0）
+struct PromotionStatsRow
+{
+    int promotions = 0;
+    int activities = 0;
+    double days = 0.0;
+};
+
+template<>
+struct RowMapping<PromotionStatsRow>
+{
+    static constexpr const char *from = "waitlist_promotions";
+    static constexpr auto columns = std::make_tuple(
+        column("COUNT(*)", &PromotionStatsRow::promotions),
+        column("COUNT(DISTINCT activity_id)", &PromotionStatsRow::activities),
+        column("COALESCE(julianday('now') - julianday(MIN(promoted_at)), 0)", &PromotionStatsRow::days));
+};
+
+#endif // ROWTYPES_H
@@ -0,0 +1,138 @@
+//【阶段28：2024-07-05】命令行自检实现
+// 自检会创建学期分片和测试活动，只能在临时数据库上运行（由main指定路径）
+
+#include "selfcheck.h"
+#include "databasemanager.h"
+#include "reportexporter.h"
+#include <QTextStream>
+#include <QTemporaryDir>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+// 初始化测试数据中的管理员和学生
+const int kAdminId = 1;
+const int kStudent1 = 3;
+const int kStudent2 = 4;
+
+bool check(QTextStream& out, bool condition, const QString& what)
+{
+    out << (condition ? "[通过] " : "[失败] ") << what << "\n";
+    return condition;
+}
+
+// 创建、审批一个活动并让学生报名，返回活动ID
+int createEnrolledActivity(const QString& title, const QString& startTime, const QString& endTime,
+                           const QList<int>& students)
+{
+    DatabaseManager& db = DatabaseManager::instance();
+    const int activityId = db.createActivity(title, QString(), "organizer1", startTime, endTime, 10, "自检");
+    if (activityId < 0 || !db.approveActivity(activityId, kAdminId)) {
+        return -1;
+    }
+    for (int student : students) {
+        bool hasConflict = false;
+        QString info;
+        if (!db.enrollActivity(student, activityId, hasConflict, info)) {
+            return -1;
+        }
+    }
+    return activityId;
+}
+
+// 把分片改回引入ID号段之前的样子：活动ID从1开始，表结构版本为4
+bool makeLegacyShard(const QString& fileName, int activityId)
+{
+    bool ok = false;
+    {
+        QSqlDatabase legacy = QSqlDatabase::addDatabase("QSQLITE", "self_check_legacy");
+        legacy.setDatabaseName(fileName);
+        if (legacy.open()) {
+            QSqlQuery query(legacy);
+            ok = query.exec(QString("UPDATE activities SET id = 1 WHERE id = %1").arg(activityId))
+                && query.exec(QString("UPDATE enrollments SET activity_id = 1 WHERE activity_id = %1").arg(activityId))
+                && query.exec("PRAGMA user_version = 4");
+            if (!ok) {
+                qDebug() << "Failed to rewrite shard" << fileName << ":" << query.lastError().text();
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase("self_check_legacy");
+    return ok;
+}
+
+}
+
+namespace SelfCheck
+{
+
+int runTermIds(QTextStream& out)
+{
+    DatabaseManager& db = DatabaseManager::instance();
+    db.setShardingEnabled(true);
+    db.setActiveTerm("2030spring");
+    if (!db.initialize()) {
+        out << "数据库初始化失败\n";
+        return 1;
+    }
+
+    bool passed = true;
+
+    // 新建的两个学期：各自的第一个活动
+    const int springId = createEnrolledActivity("春季活动", "2030-03-01 10:00:00", "2030-03-01 12:00:00",
+                                                { kStudent1 });
+    passed &= check(out, springId > 0, QString("2030spring 创建活动 %1").arg(springId));
+
+    passed &= check(out, db.rolloverTerm("2030fall"), "切换到 2030fall");
+    const int fallId = createEnrolledActivity("秋季活动", "2030-09-01 10:00:00", "2030-09-01 12:00:00",
+                                              { kStudent1, kStudent2 });
+    passed &= check(out, fallId > 0 && fallId != springId,
+                    QString("2030fall 创建活动 %1，与 2030spring 不重复").arg(fallId));
+
+    // 再切换一次，2030fall分离后改写成旧版本分片：两个学期都有ID为1的活动
+    passed &= check(out, db.rolloverTerm("2031spring"), "切换到 2031spring");
+    QFileInfo mainFile(db.database().databaseName());
+    const QString fallFile = mainFile.absoluteDir().filePath(mainFile.completeBaseName() + "_2030fall.db");
+    passed &= check(out, springId == 1, "第一个学期的号段从1开始");
+    passed &= check(out, makeLegacyShard(fallFile, fallId), "把 2030fall 改写为ID从1开始的旧分片");
+
+    // 跨学期查询附加旧分片时升级，ID移入其号段
+    QSqlQuery query(db.database());
+    QSet<int> ids;
+    QStringList idText;
+    if (query.exec(db.fanOutSql("SELECT id FROM $term.all_activities", "id"))) {
+        while (query.next()) {
+            ids.insert(query.value(0).toInt());
+            idText << query.value(0).toString();
+        }
+    }
+    passed &= check(out, idText.size() == 2 && ids.size() == 2,
+                    QString("跨学期活动ID互不重复（%1）").arg(idText.join(", ")));
+
+    // 按活动导出：每个活动一个文件，只含本活动的报名
+    QTemporaryDir outputDir;
+    ReportExporter exporter(ReportExporter::Partition::ByActivity, outputDir.path());
+    const ReportExportResult result = exporter.run();
+    QSet<QString> fileNames;
+    QList<int> rowCounts;
+    for (const ReportFileInfo& info : result.files) {
+        fileNames.insert(info.fileName);
+        rowCounts << info.rows;
+    }
+    std::sort(rowCounts.begin(), rowCounts.end());
+    passed &= check(out, result.files.size() == 2 && fileNames.size() == 2,
+                    QString("按活动导出%1个文件，文件名互不重复").arg(result.files.size()));
+    passed &= check(out, rowCounts == QList<int>({ 1, 2 }), "各文件只包含本学期活动的报名（1行和2行）");
+
+    out << (passed ? "自检通过\n" : "自检失败\n");
+    return passed ? 0 : 1;
+}
+
+}
@@ -0,0 +1,15 @@
+#ifndef SELFCHECK_H
+#define SELFCHECK_H
+
+class QTextStream;
+
+//【阶段28：2024-07-05】命令行自检：在临时数据库上复现曾出现的问题，通过返回0
+
+namespace SelfCheck
+{
+    // 学期分片的活动ID：两个学期各自的第一个活动（含升级前ID都从1开始的旧分片）
+    // 在跨学期查询和按活动导出中必须互不重复
+    int runTermIds(QTextStream& out);
+}
+
+#endif // SELFCHECK_H
@@ -0,0 +1,63 @@
+//【阶段17：2024-06-10】启动阶段计时
+
+#include "startuptrace.h"
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+// 静态初始化在main之前执行，作为进程启动的近似起点
+QElapsedTimer& processTimer()
+{
+    static QElapsedTimer timer = [] {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    return timer;
+}
+
+const QElapsedTimer& g_startTimer = processTimer();
+
+QList<QPair<QString, qint64>>& recordedPhases()
+{
+    static QList<QPair<QString, qint64>> phases;
+    return phases;
+}
+
+}
+
+namespace StartupTrace
+{
+
+void mark(const char *phase)
+{
+    if (reached(phase)) {
+        return;
+    }
+
+    const qint64 elapsed = processTimer().elapsed();
+    QList<QPair<QString, qint64>>& phases = recordedPhases();
+    const qint64 delta = phases.isEmpty() ? elapsed : elapsed - phases.last().second;
+    phases.append({ QString::fromLatin1(phase), elapsed });
+
+    qDebug().noquote() << QString("[startup] %1: %2 ms (+%3 ms)").arg(phase).arg(elapsed).arg(delta);
+}
+
+bool reached(const char *phase)
+{
+    const QString name = QString::fromLatin1(phase);
+    for (const auto& entry : recordedPhases()) {
+        if (entry.first == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QList<QPair<QString, qint64>> phases()
+{
+    return recordedPhases();
+}
+
+}
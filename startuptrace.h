@@ -0,0 +1,26 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QString>
+#include <QList>
+#include <QPair>
+
+//【阶段17：2024-06-10】启动阶段计时，定位冷启动耗时
+
+/**
+ * @brief 启动阶段追踪
+ * 计时起点为进程加载本模块时（早于main），每个阶段只记录第一次到达的时间
+ */
+namespace StartupTrace
+{
+    // 记录到达某个阶段的时间（毫秒，相对进程启动）
+    void mark(const char *phase);
+
+    // 是否已经到达过某个阶段
+    bool reached(const char *phase);
+
+    // 已记录的全部阶段
+    QList<QPair<QString, qint64>> phases();
+}
+
+#endif // STARTUPTRACE_H
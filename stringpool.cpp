@@ -0,0 +1,43 @@
+//【阶段22：2024-06-21】字符串驻留池
+
+#include "stringpool.h"
+
+namespace {
+
+QSet<QString>& pool()
+{
+    static QSet<QString> strings;
+    return strings;
+}
+
+}
+
+namespace StringPool
+{
+
+QString intern(const QString& value)
+{
+    QSet<QString>& strings = pool();
+    auto it = strings.constFind(value);
+    if (it != strings.constEnd()) {
+        return *it;
+    }
+    strings.insert(value);
+    return value;
+}
+
+int size()
+{
+    return pool().size();
+}
+
+qsizetype bytes()
+{
+    qsizetype total = 0;
+    for (const QString& value : pool()) {
+        total += value.capacity() * sizeof(QChar);
+    }
+    return total;
+}
+
+}
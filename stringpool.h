@@ -0,0 +1,23 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QString>
+#include <QSet>
+
+//【阶段22：2024-06-21】低基数字符串驻留池，状态、分类、发起人等取值全进程共享一份数据
+
+/**
+ * @brief 字符串驻留池
+ * intern返回池中与参数相等的副本，QString隐式共享，相同内容的字符串只占一份内存。
+ * 只应用于取值种类很少的字段（状态、分类、发起人用户名）；只在主线程使用。
+ */
+namespace StringPool
+{
+    QString intern(const QString& value);
+
+    // 池中字符串数量及字符数据占用的字节数
+    int size();
+    qsizetype bytes();
+}
+
+#endif // STRINGPOOL_H
@@ -1,14 +1,87 @@
 #include "studentwidget.h"
 #include "ui_studentwidget.h"
+#include "activitymodel.h"
+#include "myenrollmentsmodel.h"
+#include <QMessageBox>
 
-studentwidget::studentwidget(QWidget *parent)
+studentwidget::studentwidget(const QString& username, int userId, QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::studentwidget)
+    , m_username(username)
+    , m_userId(userId)
+    , m_activityModel(new ActivityModel(this))
+    , m_myEnrollments(new MyEnrollmentsModel(this))
+    , m_myEnrollmentsLoaded(false)
 {
     ui->setupUi(this);
+
+    // 已审批的活动，带冲突/已报名/候补/满员标注（getStudentActivityListing一次查询）
+    ui->activityTable->setModel(m_activityModel);
+    m_activityModel->refresh("student", m_userId);
+    connect(ui->activityTable->selectionModel(), &QItemSelectionModel::currentRowChanged,
+            this, &studentwidget::onActivitySelected);
+    connect(ui->refreshButton, &QPushButton::clicked, this, [this]() { m_activityModel->refresh("student", m_userId); });
+    connect(ui->enrollButton, &QPushButton::clicked, this, &studentwidget::onEnrollClicked);
+
+    // 已报名和候补中的活动：登录时不查询，首次打开该页时才以学生ID填充，之后报名变化时模型自行刷新
+    ui->myEnrollmentsTable->setModel(m_myEnrollments);
+    connect(ui->tabWidget, &QTabWidget::currentChanged, this, &studentwidget::onTabChanged);
+    onTabChanged(ui->tabWidget->currentIndex());
+
+    // 学生的时间轴只显示已审批的活动，未设置角色时会显示待审批和已拒绝的活动
+    ui->timelineView->setRole("student", m_userId);
 }
 
 studentwidget::~studentwidget()
 {
     delete ui;
 }
+
+void studentwidget::onActivitySelected()
+{
+    const QModelIndex current = ui->activityTable->currentIndex();
+    ActivityDetail detail;
+    if (!current.isValid() || !m_activityModel->activityDetail(current.row(), detail)) {
+        ui->detailsText->clear();
+        ui->enrollButton->setEnabled(false);
+        return;
+    }
+
+    ui->detailsText->setPlainText(QString("%1\n发起人：%2\n时间：%3 至 %4\n人数：%5/%6\n类别：%7\n\n%8")
+                                      .arg(detail.title, detail.organizerName, detail.startTime, detail.endTime)
+                                      .arg(detail.currentParticipants).arg(detail.maxParticipants)
+                                      .arg(detail.category, detail.description));
+    ui->enrollButton->setEnabled(true);
+}
+
+void studentwidget::onEnrollClicked()
+{
+    const QModelIndex current = ui->activityTable->currentIndex();
+    const int activityId = current.isValid() ? m_activityModel->getActivityId(current.row()) : -1;
+    if (activityId < 0) {
+        return;
+    }
+
+    bool hasConflict = false;
+    QString conflictInfo;
+    if (DatabaseManager::instance().enrollActivity(m_userId, activityId, hasConflict, conflictInfo)) {
+        QMessageBox::information(this, "报名", conflictInfo);
+    } else {
+        QMessageBox::warning(this, "报名", conflictInfo.isEmpty() ? "报名失败" : conflictInfo);
+    }
+
+    // 本进程的写入不经过变更日志通知，重新查询标注和我的报名
+    m_activityModel->refresh("student", m_userId);
+    if (m_myEnrollmentsLoaded) {
+        m_myEnrollments->refresh(m_userId);
+    }
+    onActivitySelected();
+}
+
+void studentwidget::onTabChanged(int index)
+{
+    if (!m_myEnrollmentsLoaded && ui->tabWidget->widget(index) == ui->myEnrollmentsTab) {
+        m_myEnrollmentsLoaded = true;
+        m_myEnrollments->refresh(m_userId);
+    }
+}
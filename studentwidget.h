@@ -7,16 +7,30 @@ namespace Ui {
 class studentwidget;
 }
 
+class ActivityModel;
+class MyEnrollmentsModel;
+
 class studentwidget : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit studentwidget(QWidget *parent = nullptr);
+    studentwidget(const QString& username, int userId, QWidget *parent = nullptr);
     ~studentwidget();
 
+private slots:
+    void onTabChanged(int index);
+    // 活动列表：选中后显示详情，报名后重新查询带可报名标注的列表
+    void onActivitySelected();
+    void onEnrollClicked();
+
 private:
     Ui::studentwidget *ui;
+    QString m_username;
+    int m_userId;
+    ActivityModel *m_activityModel;
+    MyEnrollmentsModel *m_myEnrollments;
+    bool m_myEnrollmentsLoaded;             // 首次切换到"我的报名"页时才查询
 };
 
 #endif // STUDENTWIDGET_H
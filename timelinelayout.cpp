@@ -0,0 +1,173 @@
+//【阶段25：2024-06-28】时间轴泳道的增量分配
+
+#include "timelinelayout.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+const qint64 kEmptyLaneStart = std::numeric_limits<qint64>::max();
+const qint64 kEmptyLaneEnd = std::numeric_limits<qint64>::min();
+
+bool startsBefore(const TimelineItem& a, const TimelineItem& b)
+{
+    return a.start < b.start;
+}
+
+}
+
+TimelineLayout::TimelineLayout()
+    : m_from(0)
+    , m_to(0)
+    , m_maxSpan(0)
+{
+}
+
+void TimelineLayout::clear()
+{
+    m_items.clear();
+    m_keys.clear();
+    m_laneStart.clear();
+    m_laneEnd.clear();
+    m_from = 0;
+    m_to = 0;
+    m_maxSpan = 0;
+}
+
+void TimelineLayout::reset(qint64 from, qint64 to, std::vector<TimelineItem> items)
+{
+    clear();
+    m_from = from;
+    m_to = from;
+    extendRight(to, std::move(items));
+}
+
+std::vector<TimelineItem> TimelineLayout::takeNew(std::vector<TimelineItem>& items)
+{
+    std::vector<TimelineItem> added;
+    added.reserve(items.size());
+    for (TimelineItem& item : items) {
+        if (item.end > item.start && !m_keys.contains(item.key)) {
+            m_keys.insert(item.key);
+            added.push_back(std::move(item));
+        }
+    }
+    return added;
+}
+
+void TimelineLayout::merge(std::vector<TimelineItem>& added)
+{
+    for (const TimelineItem& item : added) {
+        m_maxSpan = qMax(m_maxSpan, item.end - item.start);
+    }
+
+    const std::size_t middle = m_items.size();
+    m_items.insert(m_items.end(), std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()));
+    std::inplace_merge(m_items.begin(), m_items.begin() + middle, m_items.end(), startsBefore);
+}
+
+int TimelineLayout::allocateLane()
+{
+    m_laneStart.append(kEmptyLaneStart);
+    m_laneEnd.append(kEmptyLaneEnd);
+    return m_laneEnd.size() - 1;
+}
+
+void TimelineLayout::extendRight(qint64 to, std::vector<TimelineItem> items)
+{
+    std::vector<TimelineItem> added = takeNew(items);
+    std::stable_sort(added.begin(), added.end(), startsBefore);
+
+    // 泳道数通常只有几十条，逐条比较比维护堆更简单，也保证优先使用编号小的泳道
+    for (TimelineItem& item : added) {
+        int lane = 0;
+        while (lane < m_laneEnd.size() && m_laneEnd[lane] > item.start) {
+            ++lane;
+        }
+        if (lane == m_laneEnd.size()) {
+            allocateLane();
+        }
+        item.lane = lane;
+        m_laneStart[lane] = qMin(m_laneStart[lane], item.start);
+        m_laneEnd[lane] = qMax(m_laneEnd[lane], item.end);
+    }
+
+    merge(added);
+    m_to = qMax(m_to, to);
+}
+
+void TimelineLayout::extendLeft(qint64 from, std::vector<TimelineItem> items)
+{
+    std::vector<TimelineItem> added = takeNew(items);
+    std::stable_sort(added.begin(), added.end(), [](const TimelineItem& a, const TimelineItem& b) {
+        return a.end > b.end;
+    });
+
+    for (TimelineItem& item : added) {
+        int lane = 0;
+        while (lane < m_laneStart.size() && m_laneStart[lane] < item.end) {
+            ++lane;
+        }
+        if (lane == m_laneStart.size()) {
+            allocateLane();
+        }
+        item.lane = lane;
+        m_laneStart[lane] = qMin(m_laneStart[lane], item.start);
+        m_laneEnd[lane] = qMax(m_laneEnd[lane], item.end);
+    }
+
+    std::stable_sort(added.begin(), added.end(), startsBefore);
+    merge(added);
+    m_from = qMin(m_from, from);
+}
+
+void TimelineLayout::trim(qint64 from, qint64 to)
+{
+    from = qMax(from, m_from);
+    to = qMin(to, m_to);
+    if (from >= to) {
+        clear();
+        return;
+    }
+
+    auto outside = [from, to](const TimelineItem& item) {
+        return item.end <= from || item.start >= to;
+    };
+    for (const TimelineItem& item : m_items) {
+        if (outside(item)) {
+            m_keys.remove(item.key);
+        }
+    }
+    m_items.erase(std::remove_if(m_items.begin(), m_items.end(), outside), m_items.end());
+
+    m_from = from;
+    m_to = to;
+    rebuildLaneBounds();
+}
+
+void TimelineLayout::rebuildLaneBounds()
+{
+    // 丢弃项后重新计算各泳道的边界；空出的泳道可以被两个方向的新项复用，末尾的空泳道直接去掉
+    m_laneStart.fill(kEmptyLaneStart);
+    m_laneEnd.fill(kEmptyLaneEnd);
+    m_maxSpan = 0;
+    for (const TimelineItem& item : m_items) {
+        m_laneStart[item.lane] = qMin(m_laneStart[item.lane], item.start);
+        m_laneEnd[item.lane] = qMax(m_laneEnd[item.lane], item.end);
+        m_maxSpan = qMax(m_maxSpan, item.end - item.start);
+    }
+    while (!m_laneEnd.isEmpty() && m_laneEnd.last() == kEmptyLaneEnd) {
+        m_laneStart.removeLast();
+        m_laneEnd.removeLast();
+    }
+}
+
+void TimelineLayout::candidateRange(qint64 from, qint64 to, int& first, int& last) const
+{
+    // 开始时间早于 from - 最长时长 的项不可能延续到from之后
+    TimelineItem bound;
+    bound.start = from - m_maxSpan;
+    first = int(std::lower_bound(m_items.begin(), m_items.end(), bound, startsBefore) - m_items.begin());
+    bound.start = to;
+    last = int(std::lower_bound(m_items.begin(), m_items.end(), bound, startsBefore) - m_items.begin());
+}
@@ -0,0 +1,79 @@
+#ifndef TIMELINELAYOUT_H
+#define TIMELINELAYOUT_H
+
+#include <QString>
+#include <QVector>
+#include <QSet>
+#include <vector>
+
+//【阶段25：2024-06-28】时间轴的泳道分配：只保存已加载时间段内的活动，随窗口移动增量扩展
+
+// 时间轴上的一个活动块（时间为自1970年起的秒数）
+struct TimelineItem
+{
+    qint64 key = 0;             // 普通活动为活动ID，周期场次为负数（见occurrenceKey）
+    qint64 start = 0;
+    qint64 end = 0;
+    int lane = -1;
+    int activityId = -1;
+    int seriesId = -1;
+    int occurrenceIndex = -1;
+    QString title;
+    QString status;
+    int maxParticipants = 0;
+    int currentParticipants = 0;
+
+    static qint64 occurrenceKey(int seriesId, int occurrenceIndex)
+    {
+        return -((qint64(seriesId) << 32) | quint32(occurrenceIndex)) - 1;
+    }
+};
+
+/**
+ * @brief 时间轴泳道布局
+ * 已加载范围 [loadedFrom, loadedTo) 内的活动按开始时间有序保存，每个活动分配一条泳道，
+ * 同一泳道内的活动互不重叠。每条泳道记录最左项的开始时间和最右项的结束时间：
+ * 向右扩展时按开始时间顺序放入第一条结束时间不晚于它开始的泳道，向左扩展时按结束时间倒序
+ * 放入第一条开始时间不早于它结束的泳道，已有活动的泳道保持不变，滚动时不会跳动。
+ */
+class TimelineLayout
+{
+public:
+    TimelineLayout();
+
+    void clear();
+    bool isEmpty() const { return m_from >= m_to; }
+    qint64 loadedFrom() const { return m_from; }
+    qint64 loadedTo() const { return m_to; }
+
+    // 以 [from, to) 内的活动重新开始
+    void reset(qint64 from, qint64 to, std::vector<TimelineItem> items);
+    // 加载范围扩展到to / from，items为与新增时间段有交集的活动（已加载的会被跳过）
+    void extendRight(qint64 to, std::vector<TimelineItem> items);
+    void extendLeft(qint64 from, std::vector<TimelineItem> items);
+    // 丢弃与 [from, to) 没有交集的活动，已加载范围收缩到其中
+    void trim(qint64 from, qint64 to);
+
+    int laneCount() const { return m_laneEnd.size(); }
+    const std::vector<TimelineItem>& items() const { return m_items; }
+
+    // 可能与 [from, to) 有交集的活动下标范围 [first, last)，调用方仍需检查结束时间
+    void candidateRange(qint64 from, qint64 to, int& first, int& last) const;
+
+private:
+    // 去掉已加载的项，其余按开始时间归并进m_items
+    std::vector<TimelineItem> takeNew(std::vector<TimelineItem>& items);
+    void merge(std::vector<TimelineItem>& added);
+    int allocateLane();
+    void rebuildLaneBounds();
+
+    std::vector<TimelineItem> m_items;  // 按开始时间排序
+    QSet<qint64> m_keys;
+    QVector<qint64> m_laneStart;        // 各泳道最左项的开始时间，空泳道为最大值
+    QVector<qint64> m_laneEnd;          // 各泳道最右项的结束时间，空泳道为最小值
+    qint64 m_from;
+    qint64 m_to;
+    qint64 m_maxSpan;                   // 已加载活动的最长时长，用于按开始时间查找可见项
+};
+
+#endif // TIMELINELAYOUT_H
@@ -0,0 +1,478 @@
+//【阶段25：2024-06-28】时间轴视图：按视口查询、增量布局、只绘制可见部分
+
+#include "timelineview.h"
+#include "databasemanager.h"
+#include <QPainter>
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <QColor>
+
+namespace {
+
+const int kHeaderHeight = 24;
+const int kLaneHeight = 22;
+const int kMinLabelSpacing = 60;            // 刻度标签之间的最小像素距离
+
+const qint64 kHour = 3600;
+const qint64 kDay = 24 * kHour;
+
+// 缩放范围：1像素30秒（一小时120像素）到1像素6小时（一个月约120像素）
+const double kMinSecondsPerPixel = 30.0;
+const double kMaxSecondsPerPixel = 6.0 * kHour;
+const double kDefaultSecondsPerPixel = 600.0;
+
+QColor statusColor(const QString& status)
+{
+    if (status == "approved") {
+        return QColor(102, 187, 106);
+    }
+    if (status == "pending") {
+        return QColor(255, 183, 77);
+    }
+    if (status == "completed") {
+        return QColor(144, 164, 174);
+    }
+    return QColor(207, 216, 220);
+}
+
+qint64 secondsFromText(const QString& text)
+{
+    const QDateTime time = DatabaseManager::parseTime(text);
+    return time.isValid() ? time.toSecsSinceEpoch() : -1;
+}
+
+QString textFromSeconds(qint64 seconds)
+{
+    return DatabaseManager::formatTime(QDateTime::fromSecsSinceEpoch(seconds));
+}
+
+}
+
+TimelineView::TimelineView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+    , m_userId(-1)
+    , m_rangeFrom(0)
+    , m_rangeTo(0)
+    , m_secondsPerPixel(kDefaultSecondsPerPixel)
+    , m_loaded(false)
+{
+    horizontalScrollBar()->setSingleStep(20);
+    verticalScrollBar()->setSingleStep(kLaneHeight);
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
+
+    DatabaseManager& db = DatabaseManager::instance();
+    connect(&db, &DatabaseManager::activitiesChanged, this, &TimelineView::invalidate);
+    connect(&db, &DatabaseManager::enrollmentsChanged, this, &TimelineView::invalidate);
+    connect(&db, &DatabaseManager::seriesChanged, this, &TimelineView::invalidate);
+}
+
+void TimelineView::setRole(const QString& role, int userId)
+{
+    m_role = role;
+    m_userId = userId;
+    if (m_loaded) {
+        reload();
+    }
+}
+
+void TimelineView::setSecondsPerPixel(double seconds)
+{
+    seconds = qBound(kMinSecondsPerPixel, seconds, kMaxSecondsPerPixel);
+    if (seconds == m_secondsPerPixel) {
+        return;
+    }
+
+    const qint64 left = viewFrom();
+    m_secondsPerPixel = seconds;
+    updateScrollBars();
+    scrollToTime(QDateTime::fromSecsSinceEpoch(left));
+    ensureLoaded();
+    viewport()->update();
+}
+
+void TimelineView::scrollToTime(const QDateTime& time)
+{
+    horizontalScrollBar()->setValue(int((time.toSecsSinceEpoch() - m_rangeFrom) / m_secondsPerPixel));
+}
+
+void TimelineView::reload()
+{
+    m_loaded = true;
+
+    // 滚动范围覆盖全部活动，前后留出余量，并且总是包含当前时间
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    m_rangeFrom = now - 7 * kDay;
+    m_rangeTo = now + 30 * kDay;
+    QString earliest;
+    QString latest;
+    if (DatabaseManager::instance().getActivityTimeBounds(earliest, latest)) {
+        // 无法解析的时间（-1）不参与范围计算，否则范围会被拉到1970年
+        const qint64 earliestSeconds = secondsFromText(earliest);
+        const qint64 latestSeconds = secondsFromText(latest);
+        if (earliestSeconds >= 0) {
+            m_rangeFrom = qMin(m_rangeFrom, earliestSeconds - 7 * kDay);
+        }
+        if (latestSeconds >= 0) {
+            m_rangeTo = qMax(m_rangeTo, latestSeconds + 30 * kDay);
+        }
+    }
+
+    m_layout.clear();
+    updateScrollBars();
+    ensureLoaded();
+    viewport()->update();
+}
+
+void TimelineView::invalidate()
+{
+    if (!m_loaded) {
+        return;
+    }
+    m_layout.clear();
+    ensureLoaded();
+    viewport()->update();
+}
+
+qint64 TimelineView::viewFrom() const
+{
+    return m_rangeFrom + qint64(horizontalScrollBar()->value() * m_secondsPerPixel);
+}
+
+qint64 TimelineView::viewTo() const
+{
+    return viewFrom() + qint64(viewport()->width() * m_secondsPerPixel);
+}
+
+int TimelineView::timeToX(qint64 time) const
+{
+    // 视口外的时间截到边缘附近，避免远处的活动换算成像素时溢出
+    const double x = (time - viewFrom()) / m_secondsPerPixel;
+    return int(qBound(-2.0, x, double(viewport()->width() + 2)));
+}
+
+void TimelineView::updateScrollBars()
+{
+    const int contentWidth = int((m_rangeTo - m_rangeFrom) / m_secondsPerPixel);
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, qMax(0, contentWidth - viewport()->width()));
+    updateLaneScrollBar();
+}
+
+void TimelineView::updateLaneScrollBar()
+{
+    const int visibleHeight = viewport()->height() - kHeaderHeight;
+    verticalScrollBar()->setPageStep(visibleHeight);
+    verticalScrollBar()->setRange(0, qMax(0, m_layout.laneCount() * kLaneHeight - visibleHeight));
+}
+
+void TimelineView::ensureLoaded()
+{
+    if (!m_loaded || viewport()->width() <= 0) {
+        return;
+    }
+
+    // 视口前后各多加载一屏，边界按一屏宽度对齐，小幅滚动不会每次都查询
+    const qint64 from = viewFrom();
+    const qint64 to = viewTo();
+    const qint64 span = qMax(to - from, kHour);
+    const qint64 wantFrom = (from - span) / span * span;
+    const qint64 wantTo = ((to + span) / span + 1) * span;
+
+    if (m_layout.isEmpty() || wantTo <= m_layout.loadedFrom() || wantFrom >= m_layout.loadedTo()) {
+        // 跳转到不相邻的位置时重新开始
+        m_layout.reset(wantFrom, wantTo, fetch(wantFrom, wantTo));
+    } else {
+        // 只查询新露出的时间段，已加载的活动保持原有泳道
+        if (wantFrom < m_layout.loadedFrom()) {
+            m_layout.extendLeft(wantFrom, fetch(wantFrom, m_layout.loadedFrom()));
+        }
+        if (wantTo > m_layout.loadedTo()) {
+            m_layout.extendRight(wantTo, fetch(m_layout.loadedTo(), wantTo));
+        }
+    }
+
+    // 已加载范围超过五屏时丢弃远离视口的部分，内存只与视口宽度有关
+    if (m_layout.loadedTo() - m_layout.loadedFrom() > 5 * span) {
+        m_layout.trim(from - 2 * span, to + 2 * span);
+    }
+
+    updateLaneScrollBar();
+}
+
+std::vector<TimelineItem> TimelineView::fetch(qint64 from, qint64 to)
+{
+    DatabaseManager& db = DatabaseManager::instance();
+    const QString fromText = textFromSeconds(from);
+    const QString toText = textFromSeconds(to);
+
+    std::vector<TimelineItem> items;
+    for (const TimelineRow& row : db.getActivitiesInRange(fromText, toText, m_role, m_userId)) {
+        TimelineItem item;
+        item.key = row.id;
+        item.activityId = row.id;
+        item.start = secondsFromText(row.startTime);
+        item.end = secondsFromText(row.endTime);
+        item.title = row.title;
+        item.status = row.status;
+        item.maxParticipants = row.maxParticipants;
+        item.currentParticipants = row.currentParticipants;
+        if (item.start >= 0 && item.end >= 0) {
+            items.push_back(item);
+        }
+    }
+
+    // 周期活动的场次同样只展开这一时间段内的
+    for (const ActivityOccurrence& occurrence : db.getOccurrences(fromText, toText, m_role, m_userId)) {
+        TimelineItem item;
+        item.key = TimelineItem::occurrenceKey(occurrence.seriesId, occurrence.occurrenceIndex);
+        item.seriesId = occurrence.seriesId;
+        item.occurrenceIndex = occurrence.occurrenceIndex;
+        item.start = secondsFromText(occurrence.startTime);
+        item.end = secondsFromText(occurrence.endTime);
+        item.title = occurrence.title;
+        item.status = occurrence.status;
+        item.maxParticipants = occurrence.maxParticipants;
+        item.currentParticipants = occurrence.currentParticipants;
+        if (item.start >= 0 && item.end >= 0) {
+            items.push_back(item);
+        }
+    }
+
+    return items;
+}
+
+QRect TimelineView::itemRect(const TimelineItem& item) const
+{
+    const int left = timeToX(item.start);
+    const int right = timeToX(item.end);
+    const int top = kHeaderHeight + item.lane * kLaneHeight - verticalScrollBar()->value();
+    return QRect(left, top + 1, qMax(2, right - left), kLaneHeight - 2);
+}
+
+const TimelineItem *TimelineView::itemAt(const QPoint& pos) const
+{
+    if (pos.y() < kHeaderHeight) {
+        return nullptr;
+    }
+
+    const qint64 time = viewFrom() + qint64(pos.x() * m_secondsPerPixel);
+    const int lane = (pos.y() - kHeaderHeight + verticalScrollBar()->value()) / kLaneHeight;
+
+    int first = 0;
+    int last = 0;
+    m_layout.candidateRange(time, time + 1, first, last);
+    const std::vector<TimelineItem>& items = m_layout.items();
+    for (int i = first; i < last; ++i) {
+        if (items[i].lane == lane && items[i].end > time) {
+            return &items[i];
+        }
+    }
+    return nullptr;
+}
+
+void TimelineView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), palette().base());
+
+    const qint64 from = viewFrom();
+    const qint64 to = viewTo();
+    paintHeader(painter, from, to);
+
+    painter.setClipRect(0, kHeaderHeight, viewport()->width(), viewport()->height() - kHeaderHeight);
+
+    // 只遍历与视口时间段有交集的活动，再按泳道裁掉视口上下之外的
+    const int firstLane = verticalScrollBar()->value() / kLaneHeight;
+    const int lastLane = (verticalScrollBar()->value() + viewport()->height() - kHeaderHeight) / kLaneHeight;
+    int first = 0;
+    int last = 0;
+    m_layout.candidateRange(from, to, first, last);
+
+    const std::vector<TimelineItem>& items = m_layout.items();
+    const QFontMetrics metrics = fontMetrics();
+    for (int i = first; i < last; ++i) {
+        const TimelineItem& item = items[i];
+        if (item.end <= from || item.lane < firstLane || item.lane > lastLane) {
+            continue;
+        }
+
+        const QRect rect = itemRect(item);
+        QColor color = statusColor(item.status);
+        if (item.maxParticipants > 0 && item.currentParticipants >= item.maxParticipants) {
+            color = color.darker(130);
+        }
+        painter.setBrush(color);
+        // 周期活动的场次用虚线边框区分
+        painter.setPen(QPen(color.darker(150), 1, item.seriesId >= 0 ? Qt::DashLine : Qt::SolidLine));
+        painter.drawRect(rect.adjusted(0, 0, -1, -1));
+
+        if (rect.width() > 24) {
+            painter.setPen(palette().color(QPalette::Text));
+            const QRect textRect = rect.adjusted(4, 0, -4, 0);
+            painter.drawText(textRect, Qt::AlignVCenter | Qt::AlignLeft,
+                             metrics.elidedText(item.title, Qt::ElideRight, textRect.width()));
+        }
+    }
+
+    // 当前时间
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    if (now >= from && now < to) {
+        painter.setPen(QPen(Qt::red, 1));
+        const int x = timeToX(now);
+        painter.drawLine(x, kHeaderHeight, x, viewport()->height());
+    }
+}
+
+void TimelineView::paintHeader(QPainter& painter, qint64 from, qint64 to)
+{
+    painter.fillRect(0, 0, viewport()->width(), kHeaderHeight, palette().window());
+
+    // 选出相邻刻度不少于kMinLabelSpacing像素的最小间隔：小时、天、周或月
+    enum class Step { Hours, Days, Weeks, Months };
+    Step step = Step::Months;
+    int hours = 1;
+    for (int candidate : { 1, 3, 6, 12 }) {
+        if (candidate * kHour / m_secondsPerPixel >= kMinLabelSpacing) {
+            step = Step::Hours;
+            hours = candidate;
+            break;
+        }
+    }
+    if (step != Step::Hours) {
+        if (kDay / m_secondsPerPixel >= kMinLabelSpacing) {
+            step = Step::Days;
+        } else if (7 * kDay / m_secondsPerPixel >= kMinLabelSpacing) {
+            step = Step::Weeks;
+        }
+    }
+
+    // 从视口左边缘之前的第一个整刻度开始（按当地时间对齐）
+    const QDate firstDate = QDateTime::fromSecsSinceEpoch(from).date();
+    QDateTime tick;
+    QString format;
+    switch (step) {
+    case Step::Hours:
+        tick = QDateTime(firstDate, QTime(0, 0));
+        format = "MM-dd HH:mm";
+        break;
+    case Step::Days:
+        tick = QDateTime(firstDate, QTime(0, 0));
+        format = "MM-dd ddd";
+        break;
+    case Step::Weeks:
+        tick = QDateTime(firstDate.addDays(1 - firstDate.dayOfWeek()), QTime(0, 0));
+        format = "MM-dd";
+        break;
+    case Step::Months:
+        tick = QDateTime(QDate(firstDate.year(), firstDate.month(), 1), QTime(0, 0));
+        format = "yyyy-MM";
+        break;
+    }
+
+    const QColor gridColor = palette().color(QPalette::Mid);
+    while (tick.toSecsSinceEpoch() < to) {
+        if (tick.toSecsSinceEpoch() >= from - qint64(kMinLabelSpacing * m_secondsPerPixel)) {
+            const int x = timeToX(tick.toSecsSinceEpoch());
+            painter.setPen(gridColor);
+            painter.drawLine(x, 0, x, viewport()->height());
+            painter.setPen(palette().color(QPalette::WindowText));
+            painter.drawText(QRect(x + 3, 0, kMinLabelSpacing * 2, kHeaderHeight),
+                             Qt::AlignVCenter | Qt::AlignLeft, tick.toString(format));
+        }
+
+        switch (step) {
+        case Step::Hours: tick = tick.addSecs(hours * kHour); break;
+        case Step::Days: tick = tick.addDays(1); break;
+        case Step::Weeks: tick = tick.addDays(7); break;
+        case Step::Months: tick = tick.addMonths(1); break;
+        }
+    }
+
+    painter.setPen(gridColor);
+    painter.drawLine(0, kHeaderHeight - 1, viewport()->width(), kHeaderHeight - 1);
+}
+
+void TimelineView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+    ensureLoaded();
+}
+
+void TimelineView::showEvent(QShowEvent *event)
+{
+    QAbstractScrollArea::showEvent(event);
+
+    // 第一次显示时才查询，默认从前一天开始
+    if (!m_loaded) {
+        reload();
+        scrollToTime(QDateTime::currentDateTime().addDays(-1));
+    }
+}
+
+void TimelineView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dy);
+
+    if (dx != 0) {
+        ensureLoaded();
+    }
+    viewport()->update();
+}
+
+void TimelineView::wheelEvent(QWheelEvent *event)
+{
+    if (!(event->modifiers() & Qt::ControlModifier)) {
+        QAbstractScrollArea::wheelEvent(event);
+        return;
+    }
+
+    // 缩放时鼠标所指的时间保持在原位置
+    const int x = int(event->position().x());
+    const qint64 anchor = viewFrom() + qint64(x * m_secondsPerPixel);
+    setSecondsPerPixel(m_secondsPerPixel * (event->angleDelta().y() > 0 ? 0.8 : 1.25));
+    horizontalScrollBar()->setValue(int((anchor - m_rangeFrom) / m_secondsPerPixel) - x);
+    event->accept();
+}
+
+void TimelineView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    const TimelineItem *item = itemAt(event->position().toPoint());
+    if (!item) {
+        QAbstractScrollArea::mouseDoubleClickEvent(event);
+        return;
+    }
+
+    if (item->seriesId >= 0) {
+        emit occurrenceActivated(item->seriesId, item->occurrenceIndex);
+    } else {
+        emit activityActivated(item->activityId);
+    }
+}
+
+bool TimelineView::viewportEvent(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        QHelpEvent *help = static_cast<QHelpEvent *>(event);
+        const TimelineItem *item = itemAt(help->pos());
+        if (item) {
+            QString text = item->title + "\n"
+                + QDateTime::fromSecsSinceEpoch(item->start).toString("yyyy-MM-dd HH:mm") + " ~ "
+                + QDateTime::fromSecsSinceEpoch(item->end).toString("yyyy-MM-dd HH:mm") + "\n"
+                + QString("人数: %1/%2").arg(item->currentParticipants).arg(item->maxParticipants);
+            if (item->seriesId >= 0) {
+                text += QString("\n周期活动第%1场").arg(item->occurrenceIndex + 1);
+            }
+            QToolTip::showText(help->globalPos(), text, viewport());
+        } else {
+            QToolTip::hideText();
+        }
+        return true;
+    }
+    return QAbstractScrollArea::viewportEvent(event);
+}
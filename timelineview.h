@@ -0,0 +1,80 @@
+#ifndef TIMELINEVIEW_H
+#define TIMELINEVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QDateTime>
+#include <QString>
+#include "timelinelayout.h"
+
+class QPainter;
+
+//【阶段25：2024-06-28】活动时间轴视图：按周/月浏览，重叠的活动分到不同泳道
+
+/**
+ * @brief 活动时间轴视图
+ * 横向为时间、纵向为泳道，只绘制视口内的时间段和泳道。数据按时间段查询
+ * （DatabaseManager::getActivitiesInRange和getOccurrences），只保留视口前后各一屏，
+ * 滚动超出已加载范围时只查询新露出的时间段，并由TimelineLayout增量分配泳道。
+ * Ctrl+滚轮以鼠标位置为中心缩放。
+ */
+class TimelineView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit TimelineView(QWidget *parent = nullptr);
+
+    // 角色过滤同ActivityModel::refresh
+    void setRole(const QString& role, int userId = -1);
+
+    // 缩放：每像素代表的秒数
+    double secondsPerPixel() const { return m_secondsPerPixel; }
+    void setSecondsPerPixel(double seconds);
+
+    // 让视口左边缘对准time
+    void scrollToTime(const QDateTime& time);
+
+    // 重新查询时间范围和可见数据
+    void reload();
+
+signals:
+    void activityActivated(int activityId);
+    void occurrenceActivated(int seriesId, int occurrenceIndex);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    bool viewportEvent(QEvent *event) override;
+
+private slots:
+    // 数据库变更后丢弃已加载的数据，按当前视口重新查询
+    void invalidate();
+
+private:
+    void updateScrollBars();
+    void updateLaneScrollBar();
+    // 保证视口前后各一屏已加载，超出部分丢弃
+    void ensureLoaded();
+    std::vector<TimelineItem> fetch(qint64 from, qint64 to);
+    void paintHeader(QPainter& painter, qint64 from, qint64 to);
+
+    qint64 viewFrom() const;
+    qint64 viewTo() const;
+    int timeToX(qint64 time) const;
+    QRect itemRect(const TimelineItem& item) const;
+    const TimelineItem *itemAt(const QPoint& pos) const;
+
+    TimelineLayout m_layout;
+    QString m_role;
+    int m_userId;
+    qint64 m_rangeFrom;         // 横向滚动条覆盖的时间范围
+    qint64 m_rangeTo;
+    double m_secondsPerPixel;
+    bool m_loaded;
+};
+
+#endif // TIMELINEVIEW_H
@@ -0,0 +1,238 @@
+//【阶段20：2024-06-17】回放操作轨迹并统计每种操作的延迟分布
+
+#include "tracereplayer.h"
+#include "operationtrace.h"
+#include "databasemanager.h"
+#include "backupmanager.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QMap>
+#include <QVector>
+#include <QSqlQuery>
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// 界面调用方会读完查询结果，回放时同样逐行取完才算一次完整调用
+void drain(QSqlQuery query)
+{
+    while (query.next()) {
+    }
+}
+
+bool allSucceeded(const QList<ReviewResult>& results)
+{
+    return std::all_of(results.begin(), results.end(), [](const ReviewResult& r) { return r.success; });
+}
+
+// 执行一条记录，返回false表示调用报告失败
+bool replay(DatabaseManager& db, const TraceRecord& r)
+{
+    switch (r.op) {
+    case TraceOp::GetActivities:
+        drain(db.getActivities(r.text.value(0), r.userId, r.ids));
+        return true;
+    case TraceOp::GetActivityById:
+        drain(db.getActivityById(r.activityId));
+        return true;
+    case TraceOp::GetActivityDetail: {
+        ActivityDetail detail;
+        return db.getActivityDetail(r.activityId, detail);
+    }
+    case TraceOp::GetStudentListing:
+        db.getStudentActivityListing(r.userId);
+        return true;
+    case TraceOp::GetEnrollments:
+        drain(db.getEnrollments(r.activityId, r.userId));
+        return true;
+    case TraceOp::CheckTimeConflict:
+        db.checkTimeConflict(r.userId, r.text.value(0), r.text.value(1), r.activityId);
+        return true;
+    case TraceOp::CreateActivity:
+        return db.createActivity(r.text.value(0), r.text.value(1), r.text.value(2), r.text.value(3),
+                                 r.text.value(4), r.ids.value(0), r.text.value(5)) != -1;
+    case TraceOp::UpdateActivityStatus:
+        return db.updateActivityStatus(r.activityId, r.text.value(0));
+    case TraceOp::Enroll: {
+        bool hasConflict = false;
+        QString conflictInfo;
+        return db.enrollActivity(r.userId, r.activityId, hasConflict, conflictInfo);
+    }
+    case TraceOp::Cancel:
+        return db.cancelEnrollment(r.userId, r.activityId);
+    case TraceOp::AddToWaitlist:
+        return db.addToWaitlist(r.userId, r.activityId);
+    case TraceOp::ProcessWaitlist:
+        return db.processWaitlist(r.activityId);
+    case TraceOp::Approve:
+        return db.approveActivity(r.activityId, r.userId);
+    case TraceOp::Reject:
+        return db.rejectActivity(r.activityId, r.userId, r.text.value(0));
+    case TraceOp::ApproveBatch:
+        return allSucceeded(db.approveActivities(r.ids, r.userId));
+    case TraceOp::RejectBatch:
+        return allSucceeded(db.rejectActivities(r.ids, r.userId, r.text.value(0)));
+    case TraceOp::ArchiveCompleted:
+        return db.archiveCompletedData(r.ids.value(0, 30)) >= 0;
+    case TraceOp::CreateSeries:
+        return db.createActivitySeries(r.text.value(0), r.text.value(1), r.text.value(2), r.text.value(3),
+                                       r.text.value(4), r.ids.value(0), r.ids.value(1), r.ids.value(2),
+                                       r.text.value(5)) != -1;
+    case TraceOp::GetOccurrences:
+        db.getOccurrences(r.text.value(0), r.text.value(1), r.text.value(2), r.userId);
+        return true;
+    case TraceOp::EnrollOccurrence: {
+        bool hasConflict = false;
+        QString conflictInfo;
+        return db.enrollOccurrence(r.userId, r.activityId, r.ids.value(0), hasConflict, conflictInfo);
+    }
+    case TraceOp::CancelOccurrence:
+        return db.cancelOccurrenceEnrollment(r.userId, r.activityId, r.ids.value(0));
+    case TraceOp::GetActivitiesInRange:
+        db.getActivitiesInRange(r.text.value(0), r.text.value(1), r.text.value(2), r.userId);
+        return true;
+    case TraceOp::GetWaitlistStatus: {
+        WaitlistStatus status;
+        db.getWaitlistStatus(r.userId, r.activityId, status);
+        return true;
+    }
+    case TraceOp::GetWaitlistStatuses:
+        db.getWaitlistStatuses(r.userId);
+        return true;
+    case TraceOp::GetActivityPage:
+        drain(db.getActivityPage(r.text.value(0), r.userId, r.activityId, r.ids.value(0)));
+        return true;
+    case TraceOp::UpdateSeriesStatus:
+        return db.updateSeriesStatus(r.activityId, r.text.value(0));
+    case TraceOp::CancelSeriesOccurrence:
+        return db.cancelOccurrence(r.activityId, r.ids.value(0));
+    case TraceOp::RescheduleOccurrence:
+        return db.rescheduleOccurrence(r.activityId, r.ids.value(0), r.text.value(0), r.text.value(1));
+    case TraceOp::SetOccurrenceCapacity:
+        return db.setOccurrenceCapacity(r.activityId, r.ids.value(0), r.ids.value(1));
+    }
+    return false;
+}
+
+// 最近秩法取百分位，samples须已排序
+qint64 percentile(const QVector<qint64>& samples, int p)
+{
+    const int rank = int((qint64(p) * samples.size() + 99) / 100);
+    return samples.at(qBound(0, rank - 1, samples.size() - 1));
+}
+
+}
+
+TraceReplayer::TraceReplayer(const QString& traceFile, const QString& databaseFile)
+    : m_traceFile(traceFile)
+    , m_databaseFile(databaseFile)
+    , m_realTime(false)
+{
+}
+
+bool TraceReplayer::copyDatabase(const QString& targetDir, QString& copyPath, QString& error) const
+{
+    QFileInfo source(m_databaseFile);
+    if (!source.exists()) {
+        error = "数据库文件不存在: " + m_databaseFile;
+        return false;
+    }
+
+    // 主库以及同目录下的学期分片（<库名>_<学期>.db）一起复制，保持相对位置。
+    // 经SQLite连接复制而不是复制文件，-wal中已提交但未检查点的内容也在副本中
+    QStringList files = { source.fileName() };
+    files += source.absoluteDir().entryList({ source.completeBaseName() + "_*.db" }, QDir::Files);
+
+    for (const QString& file : files) {
+        QString copyError;
+        if (!BackupManager::snapshotDatabase(source.absoluteDir().filePath(file), QDir(targetDir).filePath(file),
+                                             copyError)) {
+            error = "复制数据库失败: " + file + " " + copyError;
+            return false;
+        }
+    }
+
+    copyPath = QDir(targetDir).filePath(source.fileName());
+    return true;
+}
+
+TraceReplayResult TraceReplayer::run()
+{
+    TraceReplayResult result;
+
+    QList<TraceRecord> records;
+    if (!OperationRecorder::load(m_traceFile, records, result.error)) {
+        return result;
+    }
+    if (!records.isEmpty()) {
+        result.traceDurationMs = records.last().timestampUs / 1000;
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid() || !copyDatabase(tempDir.path(), result.databaseCopy, result.error)) {
+        if (result.error.isEmpty()) {
+            result.error = "无法创建临时目录";
+        }
+        return result;
+    }
+
+    DatabaseManager& db = DatabaseManager::instance();
+    db.setDatabasePath(result.databaseCopy);
+    if (!db.initialize()) {
+        result.error = "数据库初始化失败";
+        return result;
+    }
+
+    QMap<TraceOp, QVector<qint64>> latencies;
+    QMap<TraceOp, int> failures;
+
+    QElapsedTimer clock;
+    clock.start();
+    QElapsedTimer callTimer;
+
+    for (const TraceRecord& record : records) {
+        if (m_realTime) {
+            // 按录制时的节奏等待，调用本身慢于录制时不再追赶
+            const qint64 waitUs = record.timestampUs - clock.nsecsElapsed() / 1000;
+            if (waitUs > 0) {
+                QThread::usleep(quint64(waitUs));
+            }
+        }
+
+        callTimer.start();
+        const bool ok = replay(db, record);
+        latencies[record.op].append(callTimer.nsecsElapsed() / 1000);
+        if (!ok) {
+            ++failures[record.op];
+        }
+    }
+
+    result.elapsedMs = clock.elapsed();
+    result.totalOps = records.size();
+
+    for (auto it = latencies.begin(); it != latencies.end(); ++it) {
+        QVector<qint64>& samples = it.value();
+        std::sort(samples.begin(), samples.end());
+
+        OperationLatency latency;
+        latency.name = traceOpName(it.key());
+        latency.count = samples.size();
+        latency.failed = failures.value(it.key());
+        latency.meanUs = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+        latency.p50Us = percentile(samples, 50);
+        latency.p90Us = percentile(samples, 90);
+        latency.p99Us = percentile(samples, 99);
+        latency.maxUs = samples.last();
+        result.operations.append(latency);
+    }
+
+    // 临时目录在返回时删除，先关闭连接
+    db.database().close();
+    result.ok = true;
+    return result;
+}
@@ -0,0 +1,57 @@
+#ifndef TRACEREPLAYER_H
+#define TRACEREPLAYER_H
+
+#include <QString>
+#include <QList>
+
+//【阶段20：2024-06-17】无界面回放操作轨迹，按操作统计延迟分布
+
+// 单个操作的延迟分布（微秒）
+struct OperationLatency
+{
+    QString name;
+    int count = 0;
+    int failed = 0;             // 返回失败的调用数（查询类操作不统计）
+    double meanUs = 0.0;
+    qint64 p50Us = 0;
+    qint64 p90Us = 0;
+    qint64 p99Us = 0;
+    qint64 maxUs = 0;
+};
+
+struct TraceReplayResult
+{
+    bool ok = false;
+    QString error;
+    QString databaseCopy;        // 回放使用的数据库副本（位于临时目录，结束后删除）
+    int totalOps = 0;
+    qint64 elapsedMs = 0;
+    qint64 traceDurationMs = 0;  // 录制时的时长
+    QList<OperationLatency> operations;
+};
+
+/**
+ * @brief 操作轨迹回放类
+ * 先把数据库（分片模式下连同各学期分片）经BackupManager在线复制到临时目录，
+ * 让DatabaseManager打开副本后依次重放轨迹中的调用，原数据库不受影响。
+ * 必须在DatabaseManager::initialize()之前调用run()。
+ */
+class TraceReplayer
+{
+public:
+    TraceReplayer(const QString& traceFile, const QString& databaseFile);
+
+    // true：按录制时的时间间隔回放；false（默认）：尽快回放
+    void setRealTime(bool realTime) { m_realTime = realTime; }
+
+    TraceReplayResult run();
+
+private:
+    bool copyDatabase(const QString& targetDir, QString& copyPath, QString& error) const;
+
+    QString m_traceFile;
+    QString m_databaseFile;
+    bool m_realTime;
+};
+
+#endif // TRACEREPLAYER_H
@@ -0,0 +1,109 @@
+//【阶段27：2024-07-03】候补队列名次索引实现
+
+#include "waitlistindex.h"
+
+namespace {
+
+int lowBit(int i)
+{
+    return i & -i;
+}
+
+}
+
+void WaitlistIndex::build(Queue& queue, const QVector<int>& userIds)
+{
+    // 线性时间建树：每个节点把自己的值加到父节点上
+    const int size = userIds.size();
+    queue.tree.fill(1, size + 1);
+    queue.tree[0] = 0;
+    for (int i = 1; i <= size; ++i) {
+        const int parent = i + lowBit(i);
+        if (parent <= size) {
+            queue.tree[parent] += queue.tree[i];
+        }
+    }
+
+    queue.users = userIds;
+    queue.slotByUser.clear();
+    queue.slotByUser.reserve(size);
+    for (int i = 0; i < size; ++i) {
+        queue.slotByUser.insert(userIds.at(i), i + 1);
+    }
+}
+
+void WaitlistIndex::load(int activityId, const QVector<int>& userIds)
+{
+    build(m_queues[activityId], userIds);
+}
+
+int WaitlistIndex::prefixSum(const Queue& queue, int slot)
+{
+    int sum = 0;
+    for (int i = slot; i > 0; i -= lowBit(i)) {
+        sum += queue.tree.at(i);
+    }
+    return sum;
+}
+
+void WaitlistIndex::append(int activityId, int userId)
+{
+    auto it = m_queues.find(activityId);
+    if (it == m_queues.end() || it->slotByUser.contains(userId)) {
+        return;
+    }
+
+    // 新槽位i负责区间 (i - lowbit(i), i]，其中前面各槽位的和由两个前缀和相减得到
+    Queue& queue = it.value();
+    const int slot = queue.users.size() + 1;
+    queue.tree.append(1 + prefixSum(queue, slot - 1) - prefixSum(queue, slot - lowBit(slot)));
+    queue.users.append(userId);
+    queue.slotByUser.insert(userId, slot);
+}
+
+void WaitlistIndex::remove(int activityId, int userId)
+{
+    auto it = m_queues.find(activityId);
+    if (it == m_queues.end()) {
+        return;
+    }
+
+    Queue& queue = it.value();
+    const int slot = queue.slotByUser.take(userId);
+    if (slot == 0) {
+        return;
+    }
+
+    queue.users[slot - 1] = -1;
+    for (int i = slot; i < queue.tree.size(); i += lowBit(i)) {
+        queue.tree[i] -= 1;
+    }
+
+    // 空槽过多时按剩余顺序重建，避免树只增不减
+    if (queue.users.size() > 64 && queue.slotByUser.size() * 2 < queue.users.size()) {
+        QVector<int> remaining;
+        remaining.reserve(queue.slotByUser.size());
+        for (int user : queue.users) {
+            if (user >= 0) {
+                remaining.append(user);
+            }
+        }
+        build(queue, remaining);
+    }
+}
+
+int WaitlistIndex::position(int activityId, int userId) const
+{
+    auto it = m_queues.constFind(activityId);
+    if (it == m_queues.constEnd()) {
+        return 0;
+    }
+    const int slot = it->slotByUser.value(userId, 0);
+    return slot > 0 ? prefixSum(it.value(), slot) : 0;
+}
+
+int WaitlistIndex::length(int activityId) const
+{
+    auto it = m_queues.constFind(activityId);
+    return it == m_queues.constEnd() ? 0 : it->slotByUser.size();
+}
@@ -0,0 +1,48 @@
+#ifndef WAITLISTINDEX_H
+#define WAITLISTINDEX_H
+
+#include <QVector>
+#include <QHash>
+
+//【阶段27：2024-07-03】候补队列名次索引：每个活动一棵树状数组，名次查询O(log n)
+
+/**
+ * @brief 候补队列名次索引
+ * 候补队列按加入时间排序，新加入的总在队尾，因此每个活动的队列可以表示为按加入顺序编号的
+ * 槽位数组：仍在队列中的槽位记1，已转正或移除的记0，某人的名次就是其槽位的前缀和。
+ * 前缀和用树状数组（Fenwick树）维护，加入、移除和查询名次都是O(log n)，与队列长度无关；
+ * 空槽超过一半时按剩余顺序重建。只缓存查询过的活动，由DatabaseManager在写入时同步更新。
+ */
+class WaitlistIndex
+{
+public:
+    bool isLoaded(int activityId) const { return m_queues.contains(activityId); }
+
+    // 按队列顺序装入一个活动的候补用户
+    void load(int activityId, const QVector<int>& userIds);
+    // 用户加入队尾 / 离开队列（活动未装入时忽略，下次查询时从数据库装入）
+    void append(int activityId, int userId);
+    void remove(int activityId, int userId);
+
+    // 用户在队列中的名次（从1开始），不在队列中返回0
+    int position(int activityId, int userId) const;
+    int length(int activityId) const;
+
+    void invalidate(int activityId) { m_queues.remove(activityId); }
+    void clear() { m_queues.clear(); }
+
+private:
+    struct Queue
+    {
+        QVector<int> tree;              // 树状数组，下标从1开始，tree[0]不用
+        QVector<int> users;             // 槽位 -> 用户ID，已离开的为-1
+        QHash<int, int> slotByUser;     // 用户ID -> 槽位（从1开始）
+    };
+
+    static int prefixSum(const Queue& queue, int slot);
+    static void build(Queue& queue, const QVector<int>& userIds);
+
+    QHash<int, Queue> m_queues;
+};
+
+#endif // WAITLISTINDEX_H